@@ -0,0 +1,263 @@
+/*
+author : @rebwar_ai
+*/
+#ifndef AUTOTUNER_HPP
+#define AUTOTUNER_HPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include "Layer.hpp"
+#include "NeuralNetwork.hpp"
+#include "BatchInference.hpp"
+#include "Log.hpp"
+
+namespace Autotune {
+
+    // e.g. "24-12relu-1sigmoid" or "24-c3k5relu-1sigmoid"
+    std::string topologyKey(const NeuralNetwork& nn)
+    {
+        std::stringstream key;
+        const auto& layers = nn.getLayers();
+        for (size_t l = 0; l < layers.size(); ++l)
+        {
+            if (l > 0)
+            {
+                key << "-";
+            }
+            const Layer& layer = layers[l];
+            if (layer.isConv())
+            {
+                key << "c" << layer.channels << "k" << layer.kernel_size;
+            }
+            else
+            {
+                key << layer.size;
+            }
+            switch (layer.getActivationType()) {
+                case ActivationType::ReLU: key << "relu"; break;
+                case ActivationType::Sigmoid: key << "sigmoid"; break;
+                case ActivationType::Softmax: key << "softmax"; break;
+                default: break;
+            }
+        }
+        return key.str();
+    }
+
+    // What the CPU offers, what this binary was built for, and the thread count
+    std::string cpuKey()
+    {
+        std::stringstream key;
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        key << "x86";
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse4.2")) key << "+sse4.2";
+        if (__builtin_cpu_supports("avx")) key << "+avx";
+        if (__builtin_cpu_supports("avx2")) key << "+avx2";
+        if (__builtin_cpu_supports("fma")) key << "+fma";
+        if (__builtin_cpu_supports("avx512f")) key << "+avx512f";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        key << "arm64";
+#elif defined(_M_X64)
+        key << "x64";
+#else
+        key << "generic";
+#endif
+        key << "/build";
+#if defined(__AVX512F__)
+        key << "+avx512f";
+#elif defined(__AVX2__)
+        key << "+avx2";
+#elif defined(__AVX__)
+        key << "+avx";
+#else
+        key << "+base";
+#endif
+        key << "/t" << std::thread::hardware_concurrency();
+        return key.str();
+    }
+
+    // Candidate configurations worth timing for this network on this host
+    std::vector<KernelConfig> candidates(const BatchPredictor& predictor)
+    {
+        std::vector<size_t> thread_counts = {1};
+        size_t hw = std::thread::hardware_concurrency();
+        if (hw > 1)
+        {
+            thread_counts.push_back(std::min<size_t>(hw, 4));
+            if (hw > 4)
+            {
+                thread_counts.push_back(hw);
+            }
+        }
+
+        std::vector<KernelConfig> configs;
+        for (size_t threads : thread_counts)
+        {
+            KernelConfig per_frame;
+            per_frame.packed = false;
+            per_frame.micro_batch = 1;
+            per_frame.tile = 0;
+            per_frame.threads = threads;
+            configs.push_back(per_frame);
+
+            if (!predictor.supportsPacked())
+            {
+                continue;
+            }
+            for (size_t micro_batch : {1, 4, 8, 16, 32})
+            {
+                for (size_t tile : {0, 8, 16, 32})
+                {
+                    KernelConfig config;
+                    config.packed = true;
+                    config.micro_batch = micro_batch;
+                    config.tile = tile;
+                    config.threads = threads;
+                    configs.push_back(config);
+                }
+            }
+        }
+        return configs;
+    }
+
+    // Best of `repeats` runs over the sample frames, in nanoseconds per frame
+    double measure(const BatchPredictor& predictor, const KernelConfig& config,
+                   const std::vector<std::vector<double>>& frames, size_t repeats = 3)
+    {
+        std::vector<std::vector<double>> outputs;
+        predictor.predict(frames, outputs, config);   // warm up
+
+        double best = std::numeric_limits<double>::max();
+        for (size_t r = 0; r < repeats; ++r)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            predictor.predict(frames, outputs, config);
+            auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+        }
+        return best / frames.size();
+    }
+
+    bool lookup(const std::string& filename, const std::string& key, KernelConfig& config)
+    {
+        std::ifstream file(filename);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        std::string line;
+        std::getline(file, line); // Skip header
+        while (std::getline(file, line))
+        {
+            std::stringstream ss(line);
+            std::string topology, cpu, packed, micro_batch, tile, threads;
+            std::getline(ss, topology, ',');
+            std::getline(ss, cpu, ',');
+            std::getline(ss, packed, ',');
+            std::getline(ss, micro_batch, ',');
+            std::getline(ss, tile, ',');
+            std::getline(ss, threads, ',');
+
+            if (topology + "," + cpu != key)
+            {
+                continue;
+            }
+            try {
+                config.packed = std::stoi(packed) != 0;
+                config.micro_batch = std::stoul(micro_batch);
+                config.tile = std::stoul(tile);
+                config.threads = std::stoul(threads);
+                return true;
+            } catch (const std::exception&) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    void store(const std::string& filename, const std::string& key,
+               const KernelConfig& config, double ns_per_frame)
+    {
+        bool exists = std::ifstream(filename).good();
+        std::ofstream file(filename, std::ios::app);
+        if (!file.is_open())
+        {
+            std::cerr << "Unable to open tuning file: " << filename << std::endl;
+            return;
+        }
+        if (!exists)
+        {
+            file << "topology,cpu,packed,micro_batch,tile,threads,ns_per_frame\n"; // header
+        }
+        file << key << "," << (config.packed ? 1 : 0) << "," << config.micro_batch << ","
+            << config.tile << "," << config.threads << "," << ns_per_frame << "\n";
+    }
+
+    // Fastest KernelConfig for this network on this machine. The first run times
+    // every candidate on the sample frames and appends the winner to the tuning
+    // file; later runs with the same topology and CPU read it back instantly.
+    KernelConfig tune(const BatchPredictor& predictor,
+                      const std::vector<std::vector<double>>& sample_frames,
+                      const std::string& tuning_file = "tuning.csv",
+                      bool verbose = true)
+    {
+        const std::string key = topologyKey(predictor.getNetwork()) + "," + cpuKey();
+
+        KernelConfig best;
+        if (lookup(tuning_file, key, best))
+        {
+            if (verbose)
+            {
+                std::stringstream data;
+                data << "Tuned kernels (cached " << tuning_file << "): " << best.describe() << "\n";
+                std::cout << data.str();
+                L::log(data.str());
+            }
+            return best;
+        }
+
+        if (sample_frames.empty())
+        {
+            return best;
+        }
+
+        // Enough frames to amortize thread start-up, but quick to time
+        std::vector<std::vector<double>> frames;
+        for (size_t k = 0; frames.size() < 1024; k = (k + 1) % sample_frames.size())
+        {
+            frames.push_back(sample_frames[k]);
+        }
+
+        double best_ns = std::numeric_limits<double>::max();
+        for (const KernelConfig& config : candidates(predictor))
+        {
+            double ns = measure(predictor, config, frames);
+            if (ns < best_ns)
+            {
+                best_ns = ns;
+                best = config;
+            }
+        }
+
+        store(tuning_file, key, best, best_ns);
+        if (verbose)
+        {
+            std::stringstream data;
+            data << "Tuned kernels for " << key << ": " << best.describe()
+                << " (" << best_ns << " ns/frame)\n";
+            std::cout << data.str();
+            L::log(data.str());
+        }
+        return best;
+    }
+}
+
+#endif // AUTOTUNER_HPP
@@ -0,0 +1,219 @@
+/*
+author : @rebwar_ai
+*/
+#ifndef BATCH_INFERENCE_HPP
+#define BATCH_INFERENCE_HPP
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include "Layer.hpp"
+#include "NeuralNetwork.hpp"
+
+// How BatchPredictor runs a batch of frames. The fastest choice depends on the
+// topology and the host, see Autotuner.hpp.
+struct KernelConfig {
+    bool packed = true;         // packed row-major weights, else NeuralNetwork::infer per frame
+    size_t micro_batch = 8;     // frames pushed through one weight tile together
+    size_t tile = 32;           // output columns per weight tile (0 = whole layer)
+    size_t threads = 1;         // frames are split across this many threads
+
+    std::string describe() const
+    {
+        std::stringstream data;
+        data << (packed ? "packed" : "per-frame")
+            << " micro_batch=" << micro_batch
+            << " tile=" << tile
+            << " threads=" << threads;
+        return data.str();
+    }
+};
+
+// Batched inference over a folded copy of a network. Dense layers use packed
+// row-major weights: a micro-batch of frames walks each tile of output columns
+// together, so a tile of weights is loaded into cache once per micro-batch
+// instead of once per frame. Networks with convolution layers always take the
+// per-frame path.
+class BatchPredictor
+{
+    private:
+        struct PackedLayer {
+            size_t in = 0, out = 0;
+            std::vector<double> weights;    // in x out, row-major
+            std::vector<double> bias;
+            ActivationType activation = ActivationType::None;
+        };
+
+        NeuralNetwork network;
+        std::vector<PackedLayer> packed;
+        bool packable = true;
+        size_t input_size = 0, output_size = 0, widest = 0;
+
+        // frames [begin, end) with the packed kernels
+        void runPacked(const std::vector<std::vector<double>>& inputs,
+                       std::vector<std::vector<double>>& outputs,
+                       size_t begin, size_t end, const KernelConfig& config) const
+        {
+            const size_t mb = std::max<size_t>(1, config.micro_batch);
+            std::vector<double> cur(mb * widest), next(mb * widest);
+
+            for (size_t first = begin; first < end; first += mb)
+            {
+                const size_t count = std::min(mb, end - first);
+                for (size_t b = 0; b < count; ++b)
+                {
+                    std::copy(inputs[first + b].begin(), inputs[first + b].end(), &cur[b * widest]);
+                }
+
+                for (const PackedLayer& layer : packed)
+                {
+                    const size_t tile = (config.tile == 0) ? layer.out : std::min(config.tile, layer.out);
+                    for (size_t j0 = 0; j0 < layer.out; j0 += tile)
+                    {
+                        const size_t width = std::min(tile, layer.out - j0);
+                        for (size_t b = 0; b < count; ++b)
+                        {
+                            const double* x = &cur[b * widest];
+                            double* z = &next[b * widest + j0];
+                            std::copy_n(&layer.bias[j0], width, z);
+                            for (size_t i = 0; i < layer.in; ++i)
+                            {
+                                const double xi = x[i];
+                                const double* row = &layer.weights[i * layer.out + j0];
+                                for (size_t j = 0; j < width; ++j)
+                                {
+                                    z[j] += xi * row[j];
+                                }
+                            }
+                            for (size_t j = 0; j < width; ++j)
+                            {
+                                z[j] = Activation::apply(layer.activation, z[j]);
+                            }
+                        }
+                    }
+                    if (layer.activation == ActivationType::Softmax)
+                    {
+                        for (size_t b = 0; b < count; ++b)
+                        {
+                            Activation::softmax(&next[b * widest], &next[b * widest], layer.out);
+                        }
+                    }
+                    std::swap(cur, next);
+                }
+
+                for (size_t b = 0; b < count; ++b)
+                {
+                    outputs[first + b].assign(&cur[b * widest], &cur[b * widest] + output_size);
+                }
+            }
+        }
+
+        void runPerFrame(const std::vector<std::vector<double>>& inputs,
+                         std::vector<std::vector<double>>& outputs,
+                         size_t begin, size_t end) const
+        {
+            InferenceWorkspace ws;
+            for (size_t k = begin; k < end; ++k)
+            {
+                outputs[k] = network.infer(inputs[k], ws);
+            }
+        }
+
+    public:
+        explicit BatchPredictor(const NeuralNetwork& nn)
+        : network(nn)
+        {
+            network.foldInputNormalization();
+            const auto& layers = network.getLayers();
+            const auto& weights = network.getWeights();
+            input_size = layers.front().size;
+            output_size = layers.back().size;
+
+            for (const Layer& layer : layers)
+            {
+                widest = std::max(widest, static_cast<size_t>(layer.size));
+                packable = packable && !layer.isConv();
+            }
+            // An unfoldable normalization (conv first layer) also rules out packing
+            packable = packable && (!network.hasInputNormalization() || network.isNormalizationFolded());
+            if (!packable)
+            {
+                return;
+            }
+
+            for (size_t l = 0; l < weights.size(); ++l)
+            {
+                PackedLayer layer;
+                layer.in = weights[l].getRows();
+                layer.out = weights[l].getCols();
+                layer.activation = layers[l + 1].getActivationType();
+                layer.bias = layers[l + 1].bias;
+                layer.weights.reserve(layer.in * layer.out);
+                for (size_t i = 0; i < layer.in; ++i)
+                {
+                    for (size_t j = 0; j < layer.out; ++j)
+                    {
+                        layer.weights.push_back(weights[l](i, j));
+                    }
+                }
+                packed.push_back(std::move(layer));
+            }
+        }
+
+        bool supportsPacked() const { return packable; }
+        const NeuralNetwork& getNetwork() const { return network; }
+
+        void predict(const std::vector<std::vector<double>>& inputs,
+                     std::vector<std::vector<double>>& outputs,
+                     const KernelConfig& config) const
+        {
+            for (const auto& input : inputs)
+            {
+                if (input.size() != input_size)
+                {
+                    throw std::runtime_error("Input size mismatch !");
+                }
+            }
+            outputs.resize(inputs.size());
+
+            const bool use_packed = config.packed && packable;
+            auto run = [&](size_t begin, size_t end) {
+                if (use_packed)
+                {
+                    runPacked(inputs, outputs, begin, end, config);
+                }
+                else
+                {
+                    runPerFrame(inputs, outputs, begin, end);
+                }
+            };
+
+            const size_t threads = std::max<size_t>(1, std::min(config.threads, inputs.size()));
+            if (threads == 1)
+            {
+                run(0, inputs.size());
+                return;
+            }
+
+            std::vector<std::thread> pool;
+            const size_t chunk = (inputs.size() + threads - 1) / threads;
+            for (size_t t = 0; t < threads; ++t)
+            {
+                size_t begin = t * chunk;
+                size_t end = std::min(inputs.size(), begin + chunk);
+                if (begin < end)
+                {
+                    pool.emplace_back(run, begin, end);
+                }
+            }
+            for (auto& th : pool)
+            {
+                th.join();
+            }
+        }
+};
+
+#endif // BATCH_INFERENCE_HPP
@@ -20,7 +20,9 @@ author : @rebwar_ai
 #include <numeric>   // for std::iota
 #include <random>    // for std::mt19937, std::random_device
 #include <algorithm> // for std::shuffle
-#include "log.hpp"
+#include <stdexcept>
+#include <cmath>     // for std::sqrt, std::isfinite
+#include "Log.hpp"
 #include <sstream>
 
 namespace CSV {
@@ -34,6 +36,36 @@ namespace CSV {
         return noCollisionLabels.count(label) == 0;
     }
 
+    // The robot's four actions as class indices for a softmax head. Move-Forward
+    // is class 0, so "class != 0" is the same target as isCollisionLabel.
+    const std::vector<std::string> ACTION_CLASSES = {
+        "Move-Forward", "Slight-Right-Turn", "Sharp-Right-Turn", "Slight-Left-Turn"
+    };
+
+    int actionClass(const std::string& label) {
+        for (size_t c = 0; c < ACTION_CLASSES.size(); ++c) {
+            if (ACTION_CLASSES[c] == label) {
+                return static_cast<int>(c);
+            }
+        }
+        throw std::invalid_argument("Unknown action label: " + label);
+    }
+
+    // Class-index labels ({c} per sample, as loadSensorData stores them) to
+    // one-hot rows. NeuralNetwork::train accepts either form for a softmax head.
+    std::vector<std::vector<double>> toOneHot(const std::vector<std::vector<double>>& labels,
+                                              size_t n_classes) {
+        std::vector<std::vector<double>> one_hot(labels.size(), std::vector<double>(n_classes, 0.0));
+        for (size_t k = 0; k < labels.size(); ++k) {
+            double c = labels[k].empty() ? -1.0 : labels[k][0];
+            if (!std::isfinite(c) || c < 0.0 || c >= static_cast<double>(n_classes)) {
+                throw std::out_of_range("Class index out of range");
+            }
+            one_hot[k][static_cast<size_t>(c)] = 1.0;
+        }
+        return one_hot;
+    }
+
     // Parse a single CSV line into features and label
     bool parseLine(const std::string& line, std::vector<double>& features, int& label,
                    const std::function<int(const std::string&)>& labelMapper) {
@@ -57,6 +89,10 @@ namespace CSV {
         if (!std::getline(ss, token)){
             return false;
         }
+        // Drop the '\r' left over from Windows line endings
+        while (!token.empty() && (token.back() == '\r' || token.back() == ' ')) {
+            token.pop_back();
+        }
         label = labelMapper(token);
 
         features = std::move(tempFeatures);
@@ -94,6 +130,98 @@ namespace CSV {
         L::log(data.str());
     }
 
+    // Per-feature mean and standard deviation (computed on the training split only)
+    struct FeatureStats {
+        std::vector<double> mean;
+        std::vector<double> stddev;
+    };
+
+    // Statistics over features[indices[..]] only (e.g. the training folds)
+    FeatureStats computeFeatureStats(const std::vector<std::vector<double>>& features,
+                                     const std::vector<size_t>& indices,
+                                     bool verbose = true) {
+        FeatureStats stats;
+        if (indices.empty()) {
+            return stats;
+        }
+
+        size_t n_features = features[indices[0]].size();
+        stats.mean.assign(n_features, 0.0);
+        stats.stddev.assign(n_features, 0.0);
+
+        for (size_t k : indices) {
+            for (size_t i = 0; i < n_features; ++i) {
+                stats.mean[i] += features[k][i];
+            }
+        }
+        for (double& m : stats.mean) {
+            m /= indices.size();
+        }
+
+        for (size_t k : indices) {
+            for (size_t i = 0; i < n_features; ++i) {
+                double d = features[k][i] - stats.mean[i];
+                stats.stddev[i] += d * d;
+            }
+        }
+        for (double& s : stats.stddev) {
+            s = std::sqrt(s / indices.size());
+            // A constant sensor (e.g. always saturated) is only centered, not scaled
+            if (s < 1e-12) {
+                s = 1.0;
+            }
+        }
+
+        std::stringstream data;
+        data << "----------- Feature Normalization: -----------\n";
+        data << std::fixed << std::setprecision(3);
+        for (size_t i = 0; i < n_features; ++i) {
+            data << "sensor[" << i << "] mean = " << stats.mean[i]
+                << "\t stddev = " << stats.stddev[i] << "\n";
+        }
+        data << "---------------------------------------------------\n";
+        if (verbose) {
+            L::log(data.str());
+        }
+
+        return stats;
+    }
+
+    FeatureStats computeFeatureStats(const std::vector<std::vector<double>>& features) {
+        std::vector<size_t> indices(features.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        return computeFeatureStats(features, indices);
+    }
+
+    // Split sample indices into k folds for cross-validation. Stratified folds
+    // deal each class out separately so every fold keeps the class balance.
+    std::vector<std::vector<size_t>> makeFolds(const std::vector<std::vector<double>>& labels,
+                                               size_t k,
+                                               unsigned int seed,
+                                               bool stratified = true) {
+        if (k < 2 || k > labels.size()) {
+            throw std::invalid_argument("Number of folds must be between 2 and the number of samples !");
+        }
+
+        std::vector<size_t> indices(labels.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        std::mt19937 gen(seed);
+        std::shuffle(indices.begin(), indices.end(), gen);
+
+        if (stratified) {
+            // Group by class (first label value), keeping the shuffled order inside each class
+            std::stable_sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
+                return labels[a][0] < labels[b][0];
+            });
+        }
+
+        std::vector<std::vector<size_t>> folds(k);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            folds[i % k].push_back(indices[i]);
+        }
+        return folds;
+    }
+
     // ✅ Full definition with labelMapper
     bool loadSensorData(const std::string& filename,
                               std::vector<std::vector<double>>& features,
@@ -132,7 +260,8 @@ namespace CSV {
                                 std::vector<int>& test_ids,
                                 double train_ratio = 0.8,
                                 const std::function<int(const std::string&)>& labelMapper = 
-                                    [](const std::string& l) {return isCollisionLabel(l) ? 1 : 0;})
+                                    [](const std::string& l) {return isCollisionLabel(l) ? 1 : 0;},
+                                unsigned int seed = std::random_device{}())
     {
         std::vector<std::vector<double>> all_features;
         std::vector<std::vector<double>> all_labels;
@@ -145,7 +274,7 @@ namespace CSV {
 
         std::vector<size_t> indices(all_features.size());
         std::iota(indices.begin(), indices.end(), 0);
-        std::mt19937 gen(std::random_device{}());
+        std::mt19937 gen(seed);
         std::shuffle(indices.begin(), indices.end(), gen);
 
         std::vector<std::vector<double>> features_shuffled;
@@ -0,0 +1,274 @@
+/*
+author : @rebwar_ai
+*/
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include "Matrix.hpp"
+
+// Learning rate decay used by NeuralNetwork::train
+struct LearningRateSchedule {
+    double base_lr = 0.0;
+    double decay_rate = 0.996; // decay by 0.4% each epoch
+    double min_lr = 1e-4;      // prevent it from vanishing
+
+    double at(size_t epoch) const {
+        return std::max(min_lr, base_lr * std::pow(decay_rate, epoch));
+    }
+};
+
+// Everything needed to continue a training run exactly where it stopped
+struct TrainingCheckpoint {
+    size_t next_epoch = 0;      // first epoch that still has to run
+    size_t epochs = 0;          // total epochs of the run
+    size_t batch_size = 1;
+    LearningRateSchedule schedule;
+    std::string rng_state;      // serialized std::mt19937
+    std::vector<double> input_mean;
+    std::vector<double> input_stddev;
+    bool normalization_folded = false;
+    std::vector<Matrix> weights;
+    std::vector<std::vector<double>> biases; // biases[l] belongs to layer l + 1
+};
+
+namespace Checkpoint {
+
+    // Same "type,layer,row,col,value" layout as model.csv, plus run state rows.
+    // Values are written with max_digits10 so they read back bit for bit.
+    bool write(const TrainingCheckpoint& ckpt, const std::string& filename) {
+        const std::string tmp_filename = filename + ".tmp";
+        {
+            std::ofstream file(tmp_filename);
+            if (!file.is_open()) {
+                std::cerr << "Unable to open checkpoint file: " << tmp_filename << std::endl;
+                return false;
+            }
+
+            file << std::setprecision(std::numeric_limits<double>::max_digits10);
+            file << "type,layer,row,col,value\n"; // header
+            file << "next_epoch,0,0,0," << ckpt.next_epoch << "\n";
+            file << "epochs,0,0,0," << ckpt.epochs << "\n";
+            file << "batch_size,0,0,0," << ckpt.batch_size << "\n";
+            file << "base_lr,0,0,0," << ckpt.schedule.base_lr << "\n";
+            file << "decay_rate,0,0,0," << ckpt.schedule.decay_rate << "\n";
+            file << "min_lr,0,0,0," << ckpt.schedule.min_lr << "\n";
+            file << "rng,0,0,0," << ckpt.rng_state << "\n";
+            file << "normalization_folded,0,0,0," << (ckpt.normalization_folded ? 1 : 0) << "\n";
+            for (size_t i = 0; i < ckpt.input_mean.size(); ++i)
+            {
+                file << "mean,0," << i << ",0," << ckpt.input_mean[i] << "\n";
+                file << "stddev,0," << i << ",0," << ckpt.input_stddev[i] << "\n";
+            }
+
+            for (size_t l = 0; l < ckpt.weights.size(); ++l)
+            {
+                const Matrix& w = ckpt.weights[l];
+                file << "shape," << l + 1 << "," << w.getRows() << "," << w.getCols() << ",0\n";
+                for (size_t i = 0; i < w.getRows(); ++i)
+                {
+                    for (size_t j = 0; j < w.getCols(); ++j)
+                    {
+                        file << "weight," << l + 1 << "," << i << "," << j << "," << w(i, j) << "\n";
+                    }
+                }
+                for (size_t i = 0; i < ckpt.biases[l].size(); ++i)
+                {
+                    file << "bias," << l + 1 << "," << i << ",0," << ckpt.biases[l][i] << "\n";
+                }
+            }
+
+            if (!file.good()) {
+                std::cerr << "Failed to write checkpoint file: " << tmp_filename << std::endl;
+                return false;
+            }
+        }
+
+        // Replace the previous checkpoint only once the new one is complete
+        std::error_code ec;
+        std::filesystem::rename(tmp_filename, filename, ec);
+        if (ec) {
+            std::cerr << "Unable to replace checkpoint file: " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool read(const std::string& filename, TrainingCheckpoint& ckpt) {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Unable to open checkpoint file: " << filename << std::endl;
+            return false;
+        }
+
+        ckpt = TrainingCheckpoint{};
+        std::string line;
+        std::getline(file, line); // Skip header
+
+        try {
+            while (std::getline(file, line)) {
+                std::stringstream ss(line);
+                std::string type, layerStr, rowStr, colStr, valueStr;
+
+                std::getline(ss, type, ',');
+                std::getline(ss, layerStr, ',');
+                std::getline(ss, rowStr, ',');
+                std::getline(ss, colStr, ',');
+                std::getline(ss, valueStr);
+
+                if (type == "rng") {
+                    ckpt.rng_state = valueStr;
+                    continue;
+                }
+
+                size_t layer = std::stoul(layerStr);
+                size_t row = std::stoul(rowStr);
+                size_t col = std::stoul(colStr);
+
+                if (type == "next_epoch") {
+                    ckpt.next_epoch = std::stoul(valueStr);
+                } else if (type == "epochs") {
+                    ckpt.epochs = std::stoul(valueStr);
+                } else if (type == "batch_size") {
+                    ckpt.batch_size = std::stoul(valueStr);
+                } else if (type == "base_lr") {
+                    ckpt.schedule.base_lr = std::stod(valueStr);
+                } else if (type == "decay_rate") {
+                    ckpt.schedule.decay_rate = std::stod(valueStr);
+                } else if (type == "min_lr") {
+                    ckpt.schedule.min_lr = std::stod(valueStr);
+                } else if (type == "normalization_folded") {
+                    ckpt.normalization_folded = std::stoul(valueStr) != 0;
+                } else if (type == "mean") {
+                    ckpt.input_mean.push_back(std::stod(valueStr));
+                } else if (type == "stddev") {
+                    ckpt.input_stddev.push_back(std::stod(valueStr));
+                } else if (type == "shape") {
+                    if (layer != ckpt.weights.size() + 1) {
+                        throw std::runtime_error("Checkpoint layers out of order !");
+                    }
+                    ckpt.weights.emplace_back(row, col);
+                    ckpt.biases.emplace_back(col, 0.0);
+                } else if (type == "weight") {
+                    ckpt.weights.at(layer - 1)(row, col) = std::stod(valueStr);
+                } else if (type == "bias") {
+                    ckpt.biases.at(layer - 1).at(row) = std::stod(valueStr);
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Corrupt checkpoint file " << filename << " : " << e.what() << std::endl;
+            return false;
+        }
+
+        return !ckpt.weights.empty();
+    }
+}
+
+// Writes checkpoints on a background thread so training never waits on disk.
+// The training thread copies its state into the back buffer; the worker swaps
+// it to the front and writes it out. A snapshot submitted while the previous
+// one is still being written replaces any older pending one.
+class CheckpointWriter
+{
+    private:
+        std::string filename;
+        TrainingCheckpoint buffers[2];
+        size_t front = 0;       // buffer owned by the worker
+        bool pending = false;   // back buffer holds an unwritten snapshot
+        bool writing = false;
+        bool stopping = false;
+        size_t written = 0;
+
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::thread worker;
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (true)
+            {
+                cv.wait(lock, [this] { return pending || stopping; });
+                if (!pending)
+                {
+                    return;
+                }
+
+                front = 1 - front;
+                pending = false;
+                writing = true;
+
+                lock.unlock();
+                bool ok = Checkpoint::write(buffers[front], filename);
+                lock.lock();
+
+                writing = false;
+                if (ok)
+                {
+                    ++written;
+                }
+                cv.notify_all();
+            }
+        }
+
+    public:
+        explicit CheckpointWriter(const std::string& checkpoint_file = "checkpoint.csv")
+        : filename(checkpoint_file)
+        {
+            worker = std::thread(&CheckpointWriter::run, this);
+        }
+
+        CheckpointWriter(const CheckpointWriter&) = delete;
+        CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+        ~CheckpointWriter()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            cv.notify_all();
+            worker.join();
+        }
+
+        // fill(TrainingCheckpoint&) copies the current state into the back buffer
+        template <typename Fill>
+        void submit(Fill fill)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                fill(buffers[1 - front]);
+                pending = true;
+            }
+            cv.notify_all();
+        }
+
+        // Block until every submitted snapshot is on disk
+        void flush()
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return !pending && !writing; });
+        }
+
+        size_t checkpointsWritten()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            return written;
+        }
+
+        const std::string& getFilename() const { return filename; }
+};
+
+#endif // CHECKPOINT_HPP
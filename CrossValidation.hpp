@@ -0,0 +1,171 @@
+/*
+author : @rebwar_ai
+*/
+#ifndef CROSS_VALIDATION_HPP
+#define CROSS_VALIDATION_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include <exception>
+#include <stdexcept>
+#include <mutex>
+#include <algorithm>
+#include "Layer.hpp"
+#include "NeuralNetwork.hpp"
+#include "CSVLoader.hpp"
+#include "Metrics.hpp"
+#include "Log.hpp"
+
+struct CrossValidationConfig {
+    size_t folds = 10;
+    bool stratified = true;
+    unsigned int seed = 42;        // fixes both the folds and every fold's weight init
+    double learning_rate = 0.029;
+    size_t epochs = 300;
+    size_t batch_size = 8;
+    bool normalize = true;         // standardize with each fold's training statistics
+    size_t threads = 0;            // 0 = one per hardware thread
+};
+
+struct CrossValidationResult {
+    std::vector<BinaryMetrics> folds;
+    double mean_accuracy = 0, std_accuracy = 0;
+    double mean_precision = 0, std_precision = 0;
+    double mean_recall = 0, std_recall = 0;
+    double mean_f1 = 0, std_f1 = 0;
+    long long wall_ms = 0;
+
+    std::string report() const
+    {
+        std::stringstream data;
+        data << "-------------------Cross-Validation---------------------\n";
+        data << std::fixed << std::setprecision(4);
+        for (size_t f = 0; f < folds.size(); ++f)
+        {
+            data << "Fold " << f << " : accuracy " << folds[f].accuracy() * 100
+                << "% | F1 " << folds[f].f1() * 100 << "%\n";
+        }
+        data << "\nAccuracy : " << mean_accuracy * 100 << "% +/- " << std_accuracy * 100 << "\n";
+        data << "Precision: " << mean_precision * 100 << "% +/- " << std_precision * 100 << "\n";
+        data << "Recall   : " << mean_recall * 100 << "% +/- " << std_recall * 100 << "\n";
+        data << "F1 Score : " << mean_f1 * 100 << "% +/- " << std_f1 * 100 << "\n";
+        data << "Wall Time: " << wall_ms << " ms\n";
+        return data.str();
+    }
+};
+
+namespace CV {
+
+    // Mean and sample standard deviation of metric(fold) over all folds
+    template <typename Metric>
+    void meanStd(const std::vector<BinaryMetrics>& folds, Metric metric, double& mean, double& stddev)
+    {
+        mean = 0.0;
+        for (const auto& m : folds) mean += metric(m);
+        mean /= folds.size();
+
+        stddev = 0.0;
+        for (const auto& m : folds) stddev += (metric(m) - mean) * (metric(m) - mean);
+        stddev = folds.size() > 1 ? std::sqrt(stddev / (folds.size() - 1)) : 0.0;
+    }
+
+    // Trains one model per fold concurrently. Every fold is an index view into
+    // the shared (read-only) dataset, nothing is copied per fold. Folds are
+    // scored as a binary classifier, so the network needs a single output.
+    CrossValidationResult crossValidate(const std::vector<Layer>& topology,
+                                        const std::vector<std::vector<double>>& features,
+                                        const std::vector<std::vector<double>>& labels,
+                                        const CrossValidationConfig& config = CrossValidationConfig{})
+    {
+        if (topology.empty() || topology.back().size != 1 || topology.back().isSoftmax())
+        {
+            throw std::invalid_argument("Cross-validation needs a single-output (binary) network !");
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::vector<size_t>> folds =
+            CSV::makeFolds(labels, config.folds, config.seed, config.stratified);
+
+        CrossValidationResult result;
+        result.folds.resize(folds.size());
+
+        std::atomic<size_t> next_fold{0};
+        std::exception_ptr failure;
+        std::mutex failure_mtx;
+
+        auto worker = [&]() {
+            for (size_t f = next_fold++; f < folds.size(); f = next_fold++)
+            {
+                try {
+                    std::vector<size_t> train_idx;
+                    for (size_t g = 0; g < folds.size(); ++g)
+                    {
+                        if (g != f)
+                        {
+                            train_idx.insert(train_idx.end(), folds[g].begin(), folds[g].end());
+                        }
+                    }
+
+                    NeuralNetwork nn(topology, config.seed + static_cast<unsigned int>(f));
+                    if (config.normalize)
+                    {
+                        CSV::FeatureStats stats = CSV::computeFeatureStats(features, train_idx, false);
+                        nn.setInputNormalization(stats.mean, stats.stddev);
+                    }
+                    nn.train(features, labels, train_idx, config.learning_rate,
+                             config.epochs, config.batch_size, false);
+                    nn.foldInputNormalization();
+
+                    InferenceWorkspace ws;
+                    BinaryMetrics metrics;
+                    for (size_t k : folds[f])
+                    {
+                        int predicted = nn.infer(features[k], ws)[0] >= 0.5 ? 1 : 0;
+                        metrics.add(predicted, static_cast<int>(labels[k][0]));
+                    }
+                    result.folds[f] = metrics;
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(failure_mtx);
+                    if (!failure) failure = std::current_exception();
+                }
+            }
+        };
+
+        size_t n_threads = config.threads ? config.threads : std::thread::hardware_concurrency();
+        n_threads = std::max<size_t>(1, std::min(n_threads, folds.size()));
+        std::vector<std::thread> pool;
+        for (size_t t = 0; t < n_threads; ++t)
+        {
+            pool.emplace_back(worker);
+        }
+        for (auto& t : pool)
+        {
+            t.join();
+        }
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+
+        meanStd(result.folds, [](const BinaryMetrics& m) { return m.accuracy(); },
+                result.mean_accuracy, result.std_accuracy);
+        meanStd(result.folds, [](const BinaryMetrics& m) { return m.precision(); },
+                result.mean_precision, result.std_precision);
+        meanStd(result.folds, [](const BinaryMetrics& m) { return m.recall(); },
+                result.mean_recall, result.std_recall);
+        meanStd(result.folds, [](const BinaryMetrics& m) { return m.f1(); },
+                result.mean_f1, result.std_f1);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        result.wall_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        return result;
+    }
+}
+
+#endif // CROSS_VALIDATION_HPP
@@ -0,0 +1,245 @@
+/*
+author : @rebwar_ai
+*/
+#ifndef ENSEMBLE_HPP
+#define ENSEMBLE_HPP
+
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include "Layer.hpp"
+#include "NeuralNetwork.hpp"
+
+struct EnsembleResult {
+    std::vector<std::vector<double>> members; // output of every member
+    std::vector<double> mean;                 // averaged output
+};
+
+// Runs K independently trained networks (any seeds / hidden topologies with the
+// same input and output size) as one wide network:
+//  - the first layers of all members are stacked side by side into one
+//    input x (sum of hidden sizes) matrix, so each input value is read once
+//    and drives one long contiguous row update,
+//  - deeper layers form a block-diagonal matrix per depth; each block is one
+//    member's weights stored input-major, so every input drives a contiguous
+//    row update of that member's outputs (same kernel as the first layer).
+class EnsembleEngine
+{
+    private:
+        // One member's dense connection at a given depth
+        struct Block {
+            size_t member;
+            size_t in_offset, in_size;    // slice of the previous wide activation
+            size_t out_offset, out_size;  // slice of this depth's wide activation
+            size_t weight_offset;         // into Depth::weights, in_size x out_size
+            ActivationType activation;
+        };
+
+        struct Depth {
+            size_t width = 0;
+            std::vector<double> weights;
+            std::vector<double> bias;     // width entries
+            std::vector<Block> blocks;
+            std::vector<double> a;        // wide activation scratch
+        };
+
+        size_t input_size = 0;
+        size_t output_size = 0;
+        size_t member_count = 0;
+
+        std::vector<double> first_weights;   // input_size rows of depths[0].width
+        std::vector<Depth> depths;
+        // where each member's output lives: (depth, offset)
+        std::vector<std::pair<size_t, size_t>> outputs;
+
+    public:
+        explicit EnsembleEngine(const std::vector<NeuralNetwork>& networks)
+        {
+            if (networks.empty())
+            {
+                throw std::invalid_argument("Ensemble needs at least one network !");
+            }
+
+            member_count = networks.size();
+            input_size = networks[0].getLayers().front().size;
+            output_size = networks[0].getLayers().back().size;
+
+            // Work on folded copies so the engine always consumes raw inputs
+            std::vector<NeuralNetwork> members(networks);
+            size_t max_depth = 0;
+            for (auto& nn : members)
+            {
+                nn.foldInputNormalization();
+                const auto& layers = nn.getLayers();
+                for (const Layer& layer : layers)
+                {
+                    if (layer.isConv())
+                    {
+                        throw std::invalid_argument("Ensemble members must be dense networks !");
+                    }
+                    if (layer.isSoftmax())
+                    {
+                        throw std::invalid_argument("Ensemble members can't have a softmax output !");
+                    }
+                }
+                if (static_cast<size_t>(layers.front().size) != input_size ||
+                    static_cast<size_t>(layers.back().size) != output_size)
+                {
+                    throw std::invalid_argument("Ensemble members must share input and output sizes !");
+                }
+                max_depth = std::max(max_depth, nn.getWeights().size());
+            }
+
+            depths.resize(max_depth);
+            outputs.resize(member_count);
+            std::vector<size_t> prev_offset(member_count, 0);
+
+            for (size_t d = 0; d < max_depth; ++d)
+            {
+                Depth& depth = depths[d];
+                for (size_t m = 0; m < member_count; ++m)
+                {
+                    const auto& weights = members[m].getWeights();
+                    if (d >= weights.size())
+                    {
+                        continue;
+                    }
+                    const Matrix& w = weights[d];
+                    const Layer& next = members[m].getLayers()[d + 1];
+
+                    Block block;
+                    block.member = m;
+                    block.in_offset = prev_offset[m];
+                    block.in_size = w.getRows();
+                    block.out_offset = depth.width;
+                    block.out_size = w.getCols();
+                    block.weight_offset = depth.weights.size();
+                    block.activation = next.getActivationType();
+
+                    for (size_t i = 0; i < w.getRows(); ++i)
+                    {
+                        for (size_t j = 0; j < w.getCols(); ++j)
+                        {
+                            depth.weights.push_back(w(i, j));
+                        }
+                    }
+                    depth.bias.insert(depth.bias.end(), next.bias.begin(), next.bias.end());
+
+                    depth.blocks.push_back(block);
+                    depth.width += block.out_size;
+                    prev_offset[m] = block.out_offset;
+
+                    if (d + 1 == weights.size())
+                    {
+                        outputs[m] = {d, block.out_offset};
+                    }
+                }
+                depth.a.assign(depth.width, 0.0);
+            }
+
+            // Depth 0 is re-laid out row-major (input i -> all first-layer units)
+            Depth& first = depths[0];
+            first_weights.assign(input_size * first.width, 0.0);
+            for (const Block& block : first.blocks)
+            {
+                for (size_t i = 0; i < input_size; ++i)
+                {
+                    std::copy_n(&first.weights[block.weight_offset + i * block.out_size], block.out_size,
+                                &first_weights[i * first.width + block.out_offset]);
+                }
+            }
+            first.weights.clear();
+        }
+
+        size_t size() const { return member_count; }
+
+        // All members on one frame, plus the mean of their outputs
+        EnsembleResult predict(const std::vector<double>& input)
+        {
+            EnsembleResult result;
+            predict(input, result);
+            return result;
+        }
+
+        void predict(const std::vector<double>& input, EnsembleResult& result)
+        {
+            if (input.size() != input_size)
+            {
+                throw std::runtime_error("Input size mismatch !");
+            }
+
+            // Stacked first layer: z = bias + sum_i x[i] * row_i
+            Depth& first = depths[0];
+            std::copy(first.bias.begin(), first.bias.end(), first.a.begin());
+            double* z = first.a.data();
+            for (size_t i = 0; i < input_size; ++i)
+            {
+                const double x = input[i];
+                const double* row = &first_weights[i * first.width];
+                for (size_t j = 0; j < first.width; ++j)
+                {
+                    z[j] += x * row[j];
+                }
+            }
+            for (const Block& block : first.blocks)
+            {
+                for (size_t j = block.out_offset; j < block.out_offset + block.out_size; ++j)
+                {
+                    z[j] = Activation::apply(block.activation, z[j]);
+                }
+            }
+
+            // Block-diagonal deeper layers
+            for (size_t d = 1; d < depths.size(); ++d)
+            {
+                Depth& depth = depths[d];
+                const std::vector<double>& prev = depths[d - 1].a;
+                std::copy(depth.bias.begin(), depth.bias.end(), depth.a.begin());
+                for (const Block& block : depth.blocks)
+                {
+                    const double* in = &prev[block.in_offset];
+                    double* out = &depth.a[block.out_offset];
+                    for (size_t i = 0; i < block.in_size; ++i)
+                    {
+                        const double x = in[i];
+                        const double* row = &depth.weights[block.weight_offset + i * block.out_size];
+                        for (size_t j = 0; j < block.out_size; ++j)
+                        {
+                            out[j] += x * row[j];
+                        }
+                    }
+                    for (size_t j = 0; j < block.out_size; ++j)
+                    {
+                        out[j] = Activation::apply(block.activation, out[j]);
+                    }
+                }
+            }
+
+            result.members.resize(member_count);
+            result.mean.assign(output_size, 0.0);
+            for (size_t m = 0; m < member_count; ++m)
+            {
+                const std::vector<double>& a = depths[outputs[m].first].a;
+                result.members[m].assign(a.begin() + outputs[m].second,
+                                         a.begin() + outputs[m].second + output_size);
+                for (size_t o = 0; o < output_size; ++o)
+                {
+                    result.mean[o] += result.members[m][o] / member_count;
+                }
+            }
+        }
+
+        // Frames one after another through the same buffers
+        std::vector<EnsembleResult> predictBatch(const std::vector<std::vector<double>>& inputs)
+        {
+            std::vector<EnsembleResult> results(inputs.size());
+            for (size_t k = 0; k < inputs.size(); ++k)
+            {
+                predict(inputs[k], results[k]);
+            }
+            return results;
+        }
+};
+
+#endif // ENSEMBLE_HPP
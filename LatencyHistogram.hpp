@@ -0,0 +1,130 @@
+/*
+author : @rebwar_ai
+*/
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <iomanip>
+#include <string>
+
+// HDR-style histogram of latencies in nanoseconds: exact below 2^SUB_BUCKET_BITS,
+// above that every power of two is split into 2^(SUB_BUCKET_BITS - 1) linear
+// buckets, so any recorded value is off by less than 1% (for 8 bits) and the
+// memory stays fixed no matter how many samples are recorded.
+class LatencyHistogram
+{
+    private:
+        static constexpr int SUB_BUCKET_BITS = 8;
+        static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t(1) << SUB_BUCKET_BITS;
+        static constexpr uint64_t HALF_COUNT = SUB_BUCKET_COUNT / 2;
+
+        std::vector<uint64_t> counts;
+        uint64_t total = 0;
+        uint64_t min_value = std::numeric_limits<uint64_t>::max();
+        uint64_t max_value = 0;
+        double sum = 0.0;
+
+        static int msb(uint64_t v)
+        {
+            int bit = -1;
+            while (v)
+            {
+                v >>= 1;
+                ++bit;
+            }
+            return bit;
+        }
+
+        static size_t indexOf(uint64_t v)
+        {
+            if (v < SUB_BUCKET_COUNT)
+            {
+                return static_cast<size_t>(v);
+            }
+            int shift = msb(v) - SUB_BUCKET_BITS + 1;
+            return static_cast<size_t>(shift * HALF_COUNT + (v >> shift));
+        }
+
+        // Largest value that lands in bucket idx
+        static uint64_t highestValueAt(size_t idx)
+        {
+            if (idx < SUB_BUCKET_COUNT)
+            {
+                return idx;
+            }
+            uint64_t shift = (idx - HALF_COUNT) / HALF_COUNT;
+            uint64_t sub = idx - shift * HALF_COUNT;
+            return ((sub + 1) << shift) - 1;
+        }
+
+    public:
+        LatencyHistogram()
+        : counts(indexOf(std::numeric_limits<uint64_t>::max()) + 1, 0) {}
+
+        void record(uint64_t value_ns)
+        {
+            ++counts[indexOf(value_ns)];
+            ++total;
+            min_value = std::min(min_value, value_ns);
+            max_value = std::max(max_value, value_ns);
+            sum += static_cast<double>(value_ns);
+        }
+
+        void reset()
+        {
+            std::fill(counts.begin(), counts.end(), 0);
+            total = 0;
+            min_value = std::numeric_limits<uint64_t>::max();
+            max_value = 0;
+            sum = 0.0;
+        }
+
+        // percentile in [0, 100]
+        uint64_t valueAtPercentile(double percentile) const
+        {
+            if (total == 0)
+            {
+                return 0;
+            }
+            uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * total));
+            rank = std::max<uint64_t>(1, std::min(rank, total));
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank)
+                {
+                    return std::min(highestValueAt(i), max_value);
+                }
+            }
+            return max_value;
+        }
+
+        uint64_t count() const { return total; }
+        uint64_t min() const { return total ? min_value : 0; }
+        uint64_t max() const { return max_value; }
+        double mean() const { return total ? sum / total : 0.0; }
+
+        // One line summary in microseconds
+        std::string summary() const
+        {
+            std::stringstream data;
+            data << std::fixed << std::setprecision(2)
+                << "min " << min() / 1e3
+                << " | mean " << mean() / 1e3
+                << " | p50 " << valueAtPercentile(50.0) / 1e3
+                << " | p99 " << valueAtPercentile(99.0) / 1e3
+                << " | p99.9 " << valueAtPercentile(99.9) / 1e3
+                << " | max " << max() / 1e3 << " us";
+            return data.str();
+        }
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
@@ -9,6 +9,7 @@ author : @rebwar_ai
 #include <cmath>
 #include <stdexcept>
 #include <random>
+#include <algorithm>
 
 // Define a type alias for activation functions
 using ActivationFunction = std::function<double(double)>;
@@ -22,15 +23,74 @@ namespace Activation {
         double s = sigmoid(x);
         return s * (1.0 - s);
     }
+
+    // out = softmax(z), shifted by max(z) so exp() never overflows
+    inline void softmax(const double* z, double* out, size_t n) {
+        double zmax = *std::max_element(z, z + n);
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = std::exp(z[i] - zmax);
+            sum += out[i];
+        }
+        double inv = 1.0 / sum;
+        for (size_t i = 0; i < n; ++i) {
+            out[i] *= inv;
+        }
+    }
+
+    // Softmax and cross-entropy in one pass over the logits z and the target
+    // distribution y (one-hot, or any y summing to 1):
+    //   p    = softmax(z)
+    //   loss = -sum_i y_i log p_i = sum_i y_i (logsumexp(z) - z_i)
+    //   grad = dloss/dz = p - y
+    // The loss comes from log-sum-exp rather than log(p), so it stays finite
+    // however confident the prediction is. Returns the loss.
+    inline double softmaxCrossEntropy(const double* z, const double* y,
+                                      double* p, double* grad, size_t n) {
+        double zmax = *std::max_element(z, z + n);
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            p[i] = std::exp(z[i] - zmax);
+            sum += p[i];
+        }
+        const double lse = zmax + std::log(sum);
+        const double inv = 1.0 / sum;
+        double loss = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            p[i] *= inv;
+            grad[i] = p[i] - y[i];
+            loss += y[i] * (lse - z[i]);
+        }
+        return loss;
+    }
 }
 
 // Enum for specifying activation types
 enum class ActivationType {
     None,
     ReLU,
-    Sigmoid
+    Sigmoid,
+    Softmax     // output layer only, normalizes the whole layer (see Activation::softmax)
 };
 
+namespace Activation {
+    // Elementwise activation without the std::function indirection, for the
+    // packed inference kernels. Softmax isn't elementwise: this returns the
+    // logit and the caller normalizes the whole layer with softmax().
+    inline double apply(ActivationType type, double x) {
+        switch (type) {
+            case ActivationType::ReLU:
+                return relu(x);
+            case ActivationType::Sigmoid:
+                return sigmoid(x);
+            case ActivationType::Softmax:
+            case ActivationType::None:
+            default:
+                return x;
+        }
+    }
+}
+
 // Return a pair of activation function and its derivative based on type
 inline std::pair<ActivationFunction, ActivationFunction>
 getActivationPair(ActivationType type) {
@@ -40,21 +100,32 @@ getActivationPair(ActivationType type) {
             return {relu, reluDerivative};
         case ActivationType::Sigmoid:
             return {sigmoid, sigmoidDerivative};
+        case ActivationType::Softmax:   // not elementwise, applied to the whole layer
         case ActivationType::None:
         default:
             return {ActivationFunction{}, ActivationFunction{}};
     }
 }
 
+// How a layer is connected to the layer before it
+enum class LayerType {
+    Dense,          // full weight matrix
+    CircularConv    // shared 1D kernels over a ring, wrap-around padding
+};
+
 // Layer structure
 struct Layer {
 private:
     ActivationFunction activation;
     ActivationFunction activation_derivative;
+    ActivationType activation_type;
 
 public:
     int layer_index;
     int size;
+    LayerType type = LayerType::Dense;
+    int channels = 1;       // CircularConv: values stored channel-major, a[c * positions() + p]
+    int kernel_size = 0;    // CircularConv: taps per kernel (odd, centered)
     std::vector<double> z;      // Pre-activation values
     std::vector<double> a;      // Activation output values
     std::vector<double> bias;   // Biases (not for input layer)
@@ -62,7 +133,8 @@ public:
 
     // Constructor
     Layer(int index, int size, ActivationType act_type)
-        : layer_index(index),size(size), z(size, 0.0), a(size, 0.0) {
+        : activation_type(index != 0 ? act_type : ActivationType::None),
+          layer_index(index),size(size), z(size, 0.0), a(size, 0.0) {
         if(size <= 0 )
         {
             throw std::invalid_argument("Layer sizes must be positive !");
@@ -115,9 +187,34 @@ public:
         return activation_derivative(x);
     }
 
+    // Circular 1D convolution over a ring of `positions` values (e.g. the 24
+    // sonar sensors around the robot) with `channels` output kernels of
+    // `kernel_size` taps each. Kernels and biases are shared by all positions,
+    // so the layer has one bias per channel.
+    static Layer circularConv(int index, int positions, int channels, int kernel_size,
+                              ActivationType act_type) {
+        if (index == 0 || positions <= 0 || channels <= 0) {
+            throw std::invalid_argument("Convolution layers need a previous layer and positive sizes !");
+        }
+        if (kernel_size <= 0 || kernel_size % 2 == 0 || kernel_size > positions) {
+            throw std::invalid_argument("Kernel size must be odd and no larger than the ring !");
+        }
+        Layer layer(index, positions * channels, act_type);
+        layer.type = LayerType::CircularConv;
+        layer.channels = channels;
+        layer.kernel_size = kernel_size;
+        layer.bias.assign(channels, 0.0);
+        return layer;
+    }
+
+    int positions() const { return size / channels; }
+    bool isConv() const { return type == LayerType::CircularConv; }
+    bool isSoftmax() const { return activation_type == ActivationType::Softmax; }
+
     // Optional helper methods
     bool hasActivation() const { return static_cast<bool>(activation); }
     bool hasDerivative() const { return static_cast<bool>(activation_derivative); }
+    ActivationType getActivationType() const { return activation_type; }
 };
 
 #endif // LAYER_HPP
@@ -47,6 +47,10 @@ public:
     Matrix& fillRandom(double min = -1.0, double max = 1.0) {
         std::random_device rd;
         std::mt19937 gen(rd());
+        return fillRandom(gen, min, max);
+    }
+
+    Matrix& fillRandom(std::mt19937& gen, double min = -1.0, double max = 1.0) {
         std::uniform_real_distribution<> dist(min, max);
 
         for (size_t i = 0; i < (*this).getRows(); ++i) {
@@ -0,0 +1,142 @@
+/*
+author : @rebwar_ai
+*/
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+// Confusion matrix of a binary classifier (1 = collision)
+struct BinaryMetrics {
+    int tp = 0, tn = 0, fp = 0, fn = 0;
+
+    void add(int predicted, int actual)
+    {
+        if (predicted == 1 && actual == 1) tp++;
+        else if (predicted == 0 && actual == 0) tn++;
+        else if (predicted == 1 && actual == 0) fp++;
+        else if (predicted == 0 && actual == 1) fn++;
+    }
+
+    int total() const { return tp + tn + fp + fn; }
+
+    double accuracy() const
+    {
+        return total() == 0 ? 0.0 : static_cast<double>(tp + tn) / total();
+    }
+    double precision() const
+    {
+        return (tp + fp) == 0 ? 0.0 : static_cast<double>(tp) / (tp + fp);
+    }
+    double recall() const
+    {
+        return (tp + fn) == 0 ? 0.0 : static_cast<double>(tp) / (tp + fn);
+    }
+    double f1() const
+    {
+        double p = precision(), r = recall();
+        return (p + r) == 0 ? 0.0 : 2.0 * (p * r) / (p + r);
+    }
+
+    std::string report() const
+    {
+        std::stringstream data;
+        data << "\nConfusion Matrix:\n";
+        data << "TP: " << tp << " | FP: " << fp << "\n";
+        data << "FN: " << fn << " | TN: " << tn << "\n";
+
+        data << std::fixed << std::setprecision(4);
+        data << "\nAccuracy : " << accuracy() * 100 << "%\n";
+        data << "Precision: " << precision() * 100 << "%\n";
+        data << "Recall   : " << recall() * 100 << "%\n";
+        data << "F1 Score : " << f1() * 100 << "%\n";
+        return data.str();
+    }
+};
+
+// Confusion matrix over n classes: confusion[actual][predicted]
+struct MultiClassMetrics {
+    std::vector<std::string> names;
+    std::vector<std::vector<int>> confusion;
+
+    explicit MultiClassMetrics(const std::vector<std::string>& class_names)
+    : names(class_names), confusion(class_names.size(), std::vector<int>(class_names.size(), 0)) {}
+
+    void add(int predicted, int actual)
+    {
+        confusion.at(actual).at(predicted)++;
+    }
+
+    int total() const
+    {
+        int n = 0;
+        for (const auto& row : confusion)
+            for (int c : row) n += c;
+        return n;
+    }
+
+    double accuracy() const
+    {
+        int correct = 0;
+        for (size_t c = 0; c < confusion.size(); ++c) correct += confusion[c][c];
+        return total() == 0 ? 0.0 : static_cast<double>(correct) / total();
+    }
+    double precision(size_t c) const
+    {
+        int predicted = 0;
+        for (const auto& row : confusion) predicted += row[c];
+        return predicted == 0 ? 0.0 : static_cast<double>(confusion[c][c]) / predicted;
+    }
+    double recall(size_t c) const
+    {
+        int actual = 0;
+        for (int n : confusion[c]) actual += n;
+        return actual == 0 ? 0.0 : static_cast<double>(confusion[c][c]) / actual;
+    }
+    double f1(size_t c) const
+    {
+        double p = precision(c), r = recall(c);
+        return (p + r) == 0 ? 0.0 : 2.0 * (p * r) / (p + r);
+    }
+    double macroF1() const
+    {
+        double sum = 0.0;
+        for (size_t c = 0; c < confusion.size(); ++c) sum += f1(c);
+        return confusion.empty() ? 0.0 : sum / confusion.size();
+    }
+
+    std::string report() const
+    {
+        size_t width = 8;
+        for (const auto& name : names) width = std::max(width, name.size() + 6);
+
+        std::stringstream data;
+        data << "\nConfusion Matrix (rows = actual, columns = predicted):\n";
+        data << std::setw(width) << "";
+        for (size_t c = 0; c < names.size(); ++c) data << std::setw(8) << ("[" + std::to_string(c) + "]");
+        data << "\n";
+        for (size_t a = 0; a < names.size(); ++a)
+        {
+            data << std::left << std::setw(width) << ("[" + std::to_string(a) + "] " + names[a]) << std::right;
+            for (int n : confusion[a]) data << std::setw(8) << n;
+            data << "\n";
+        }
+
+        data << std::fixed << std::setprecision(4);
+        data << "\n";
+        for (size_t c = 0; c < names.size(); ++c)
+        {
+            data << "[" << c << "] Precision " << precision(c) * 100 << "% | Recall "
+                << recall(c) * 100 << "% | F1 " << f1(c) * 100 << "%\n";
+        }
+        data << "\nAccuracy : " << accuracy() * 100 << "%\n";
+        data << "Macro F1 : " << macroF1() * 100 << "%\n";
+        return data.str();
+    }
+};
+
+#endif // METRICS_HPP
@@ -0,0 +1,210 @@
+/*
+author : @rebwar_ai
+*/
+#ifndef MODEL_SERVER_HPP
+#define MODEL_SERVER_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include "NeuralNetwork.hpp"
+
+// One immutable version of the model. Prediction threads hold it through a
+// shared_ptr, so it stays alive until the last reader drops it.
+// If the published network had a prediction cache, the snapshot gets its own
+// empty one, so a swap never serves answers of the previous version.
+class ModelSnapshot
+{
+    private:
+        const NeuralNetwork network;
+        size_t version = 0;     // numbered by ModelServer when it is installed
+        const std::string source;
+
+        friend class ModelServer;
+
+    public:
+        ModelSnapshot(const NeuralNetwork& nn, const std::string& source)
+        : network(nn), source(source) {}
+
+        std::vector<double> predict(const std::vector<double>& input) const
+        {
+            thread_local InferenceWorkspace ws;
+            return network.predict(input, ws);
+        }
+
+        const NeuralNetwork& getNetwork() const { return network; }
+        size_t getVersion() const { return version; }
+        const std::string& getSource() const { return source; }
+};
+
+// Serves predictions from the current snapshot and swaps in new ones RCU style.
+// Every reader thread keeps its own reference to the snapshot it last used and
+// only checks one atomic version number per prediction, so the read path takes
+// no lock and touches no shared reference count. When the version moves, the
+// reader re-acquires the new snapshot once under publish_mtx. A loader builds
+// the next snapshot off to the side, and the old snapshot is freed when the
+// last reader has moved on (a thread that stops predicting keeps its last
+// snapshot alive until it exits).
+class ModelServer
+{
+    private:
+        std::vector<Layer> topology;
+
+        // `current` and next_version are guarded by publish_mtx;
+        // published_version mirrors the current version and is what readers poll
+        std::shared_ptr<const ModelSnapshot> current;
+        mutable std::mutex publish_mtx;
+        std::atomic<size_t> published_version{0};
+        size_t next_version = 1;
+
+        // Tells the servers apart in the per-thread cache; addresses can be reused
+        const size_t server_id;
+        static size_t nextServerId()
+        {
+            static std::atomic<size_t> ids{1};
+            return ids++;
+        }
+
+        struct ReaderCache {
+            size_t server_id = 0;
+            size_t version = 0;
+            std::shared_ptr<const ModelSnapshot> snapshot;
+        };
+
+        // This thread's reference to the current snapshot
+        const std::shared_ptr<const ModelSnapshot>& localSnapshot() const
+        {
+            thread_local ReaderCache cache;
+            size_t version = published_version.load(std::memory_order_acquire);
+            if (cache.server_id != server_id || cache.version != version)
+            {
+                std::lock_guard<std::mutex> lock(publish_mtx);
+                cache.server_id = server_id;
+                cache.snapshot = current;
+                cache.version = current ? current->getVersion() : 0;
+            }
+            return cache.snapshot;
+        }
+
+        std::thread watcher;
+        std::mutex watch_mtx;
+        std::condition_variable watch_cv;
+        bool stopping = false;
+
+    public:
+        explicit ModelServer(const std::vector<Layer>& network_layers)
+        : topology(network_layers), server_id(nextServerId()) {}
+
+        ModelServer(const ModelServer&) = delete;
+        ModelServer& operator=(const ModelServer&) = delete;
+
+        ~ModelServer()
+        {
+            stopWatching();
+        }
+
+        // A reference for callers that use one version across several calls
+        std::shared_ptr<const ModelSnapshot> acquire() const
+        {
+            return localSnapshot();
+        }
+
+        std::vector<double> predict(const std::vector<double>& input) const
+        {
+            const std::shared_ptr<const ModelSnapshot>& snapshot = localSnapshot();
+            if (!snapshot)
+            {
+                throw std::runtime_error("No model has been published yet !");
+            }
+            return snapshot->predict(input);
+        }
+
+        size_t publish(const NeuralNetwork& nn, const std::string& source = "memory")
+        {
+            // Copy the network before taking the lock, readers may be waiting on it.
+            // The version is only assigned under the lock, so concurrent publishers
+            // install their snapshots in version order.
+            auto snapshot = std::make_shared<ModelSnapshot>(nn, source);
+            std::lock_guard<std::mutex> lock(publish_mtx);
+            snapshot->version = next_version++;
+            current = snapshot;
+            published_version.store(snapshot->version, std::memory_order_release);
+            return snapshot->version;
+        }
+
+        // Build a snapshot from a model file and publish it if it loads completely
+        bool loadAndPublish(const std::string& filename)
+        {
+            try {
+                NeuralNetwork nn(topology, 0);
+                if (!nn.loadModel(filename))
+                {
+                    return false;
+                }
+                publish(nn, filename);
+                return true;
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to load model " << filename << " : " << e.what() << std::endl;
+                return false;
+            }
+        }
+
+        // Reload the model in the background whenever the file changes on disk
+        void watch(const std::string& filename,
+                   std::chrono::milliseconds poll_interval = std::chrono::milliseconds(500))
+        {
+            stopWatching();
+            {
+                std::lock_guard<std::mutex> lock(watch_mtx);
+                stopping = false;
+            }
+
+            watcher = std::thread([this, filename, poll_interval] {
+                std::filesystem::file_time_type last_seen{};
+                std::unique_lock<std::mutex> lock(watch_mtx);
+                while (!stopping)
+                {
+                    std::error_code ec;
+                    auto modified = std::filesystem::last_write_time(filename, ec);
+                    if (!ec && modified != last_seen)
+                    {
+                        lock.unlock();
+                        if (loadAndPublish(filename))
+                        {
+                            last_seen = modified;
+                        }
+                        lock.lock();
+                    }
+                    watch_cv.wait_for(lock, poll_interval, [this] { return stopping; });
+                }
+            });
+        }
+
+        void stopWatching()
+        {
+            {
+                std::lock_guard<std::mutex> lock(watch_mtx);
+                stopping = true;
+            }
+            watch_cv.notify_all();
+            if (watcher.joinable())
+            {
+                watcher.join();
+            }
+        }
+
+        size_t currentVersion() const
+        {
+            return published_version.load(std::memory_order_acquire);
+        }
+};
+
+#endif // MODEL_SERVER_HPP
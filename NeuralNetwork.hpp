@@ -11,22 +11,275 @@ author : @rebwar_ai
 #include <stdexcept>
 #include <cmath>
 #include <chrono>
+#include <random>
+#include <iomanip>
+#include <limits>
+#include <filesystem>
+#include <numeric>
 #include "Layer.hpp"
 #include "Matrix.hpp"
 #include "Log.hpp"
+#include "Checkpoint.hpp"
+#include "PredictionCache.hpp"
+#include <optional>
 #include <sstream>
 
+// Per-thread activations for the const inference path (NeuralNetwork::infer)
+struct InferenceWorkspace {
+    std::vector<std::vector<double>> z;
+    std::vector<std::vector<double>> a;
+};
+
 class NeuralNetwork
 {
     private:
         std::vector<Layer> layers;
         std::vector<Matrix> weights;
+        std::mt19937 rng;
+
+        // Input normalization x' = (x - mean) / stddev. While it is not folded
+        // into the first layer, forward() applies it to every input.
+        std::vector<double> input_mean;
+        std::vector<double> input_stddev;
+        bool normalization_folded = false;
+
+        // Optional, see enablePredictionCache(). Internally synchronized, so the
+        // const predict() may fill it from any number of threads.
+        mutable std::optional<PredictionCache> prediction_cache;
+
+        void invalidatePredictionCache()
+        {
+            if (prediction_cache)
+            {
+                prediction_cache->clear();
+            }
+        }
 
         void connect_layers()
         {
             for (size_t i = 0; i < layers.size() - 1;++i)
             {
-                weights.emplace_back(layers[i].size, layers[i + 1].size);
+                if (layers[i + 1].isConv())
+                {
+                    // Shared kernels: row k * in_channels + ci, column = output channel
+                    const Layer& conv = layers[i + 1];
+                    if (layers[i].size != conv.positions() * layers[i].channels)
+                    {
+                        throw std::invalid_argument("Convolution ring size doesn't match the previous layer !");
+                    }
+                    weights.emplace_back(conv.kernel_size * layers[i].channels, conv.channels);
+                }
+                else
+                {
+                    weights.emplace_back(layers[i].size, layers[i + 1].size);
+                }
+
+                if (layers[i + 1].isSoftmax() &&
+                    (i + 2 != layers.size() || layers[i + 1].isConv() || layers[i + 1].size < 2))
+                {
+                    throw std::invalid_argument("Softmax is only supported on a dense output layer of at least 2 classes !");
+                }
+            }
+        }
+
+        // y[p] += w * x[(p + shift) mod n], split into two wrap-free runs so
+        // both loops are plain contiguous axpy's the compiler can vectorize
+        static void axpyWrapped(double w, const double* x, double* y, size_t n, size_t shift)
+        {
+            const size_t head = n - shift;
+            for (size_t p = 0; p < head; ++p)
+            {
+                y[p] += w * x[p + shift];
+            }
+            for (size_t p = head; p < n; ++p)
+            {
+                y[p] += w * x[p - head];
+            }
+        }
+
+        // sum_p y[p] * x[(p + shift) mod n]
+        static double dotWrapped(const double* x, const double* y, size_t n, size_t shift)
+        {
+            const size_t head = n - shift;
+            double sum = 0.0;
+            for (size_t p = 0; p < head; ++p)
+            {
+                sum += y[p] * x[p + shift];
+            }
+            for (size_t p = head; p < n; ++p)
+            {
+                sum += y[p] * x[p - head];
+            }
+            return sum;
+        }
+
+        // Kernel tap k reads the input `k - kernel_size / 2` positions away
+        static size_t tapShift(int k, int kernel_size, size_t n)
+        {
+            long offset = k - kernel_size / 2;
+            return static_cast<size_t>((offset % static_cast<long>(n) + static_cast<long>(n)) % static_cast<long>(n));
+        }
+
+        // Circular convolution l -> l + 1 (layers[l + 1].isConv())
+        void propagateConv(size_t l, const std::vector<double>& in,
+                           std::vector<double>& z, std::vector<double>& out) const
+        {
+            const Matrix& w = weights[l];
+            const Layer& next = layers[l + 1];
+            const size_t n = next.positions();
+            const int in_channels = layers[l].channels;
+
+            for (int co = 0; co < next.channels; ++co)
+            {
+                double* zc = &z[co * n];
+                std::fill(zc, zc + n, next.bias[co]);
+
+                for (int k = 0; k < next.kernel_size; ++k)
+                {
+                    const size_t shift = tapShift(k, next.kernel_size, n);
+                    for (int ci = 0; ci < in_channels; ++ci)
+                    {
+                        axpyWrapped(w(k * in_channels + ci, co), &in[ci * n], zc, n, shift);
+                    }
+                }
+            }
+
+            for (size_t j = 0; j < z.size(); ++j)
+            {
+                out[j] = next.applyActivation(z[j]);
+            }
+        }
+
+        // dL/da of layer l from the gradient of layer l + 1
+        void backpropagateError(size_t l, std::vector<double>& error) const
+        {
+            const Matrix& w = weights[l];
+            const Layer& next = layers[l + 1];
+
+            if (next.isConv())
+            {
+                const size_t n = next.positions();
+                const int in_channels = layers[l].channels;
+                std::fill(error.begin(), error.end(), 0.0);
+
+                // z_co[p] uses a_ci[p + s], so a_ci[q] collects g_co[q - s]
+                for (int co = 0; co < next.channels; ++co)
+                {
+                    const double* g = &next.gradient[co * n];
+                    for (int k = 0; k < next.kernel_size; ++k)
+                    {
+                        const size_t back = (n - tapShift(k, next.kernel_size, n)) % n;
+                        for (int ci = 0; ci < in_channels; ++ci)
+                        {
+                            axpyWrapped(w(k * in_channels + ci, co), g, &error[ci * n], n, back);
+                        }
+                    }
+                }
+                return;
+            }
+
+            for (size_t i = 0; i < w.getRows();++i)
+            {
+                double sum = 0.0;
+                for (size_t j = 0;j < w.getCols();++j)
+                {
+                    sum += next.gradient[j] * w(i, j);
+                }
+                error[i] = sum;
+            }
+        }
+
+        // Add this sample's weight and bias gradients for connection l -> l + 1
+        void accumulateGradients(size_t l, Matrix& weight_gradient, std::vector<double>& bias_gradient) const
+        {
+            const std::vector<double>& activations = layers[l].a;
+            const Layer& next = layers[l + 1];
+
+            if (next.isConv())
+            {
+                const size_t n = next.positions();
+                const int in_channels = layers[l].channels;
+                for (int co = 0; co < next.channels; ++co)
+                {
+                    const double* g = &next.gradient[co * n];
+                    for (int k = 0; k < next.kernel_size; ++k)
+                    {
+                        const size_t shift = tapShift(k, next.kernel_size, n);
+                        for (int ci = 0; ci < in_channels; ++ci)
+                        {
+                            weight_gradient(k * in_channels + ci, co) +=
+                                dotWrapped(&activations[ci * n], g, n, shift);
+                        }
+                    }
+                    for (size_t p = 0; p < n; ++p)
+                    {
+                        bias_gradient[co] += g[p];
+                    }
+                }
+                return;
+            }
+
+            for (size_t i = 0; i < weight_gradient.getRows();++i)
+            {
+                for (size_t j = 0;j < weight_gradient.getCols();++j)
+                {
+                    weight_gradient(i, j) += next.gradient[j] * activations[i];
+                }
+            }
+
+            for (size_t i = 0; i < next.bias.size(); ++i)
+            {
+                bias_gradient[i] += next.gradient[i];
+            }
+        }
+
+        // Connection l -> l + 1 on caller-provided buffers
+        void propagateLayer(size_t l, const std::vector<double>& in,
+                            std::vector<double>& z, std::vector<double>& out) const
+        {
+            if (layers[l + 1].isConv())
+            {
+                propagateConv(l, in, z, out);
+                return;
+            }
+
+            const Matrix& w = weights[l];
+            const Layer& next = layers[l + 1];
+
+            for (size_t j = 0; j < w.getCols();++j)
+            {
+                double sum = next.bias[j];
+
+                for (size_t i = 0; i < w.getRows();++i)
+                {
+                    sum += in[i] * w(i, j);
+                }
+
+                z[j] = sum;
+                if (!next.isSoftmax())
+                {
+                    out[j] = next.applyActivation(sum);
+                }
+            }
+
+            if (next.isSoftmax())
+            {
+                Activation::softmax(z.data(), out.data(), z.size());
+            }
+        }
+
+        void normalizeInput(const std::vector<double>& input, std::vector<double>& out) const
+        {
+            if (!input_mean.empty() && !normalization_folded)
+            {
+                for (size_t i = 0; i < input.size(); ++i)
+                {
+                    out[i] = (input[i] - input_mean[i]) / input_stddev[i];
+                }
+            }
+            else
+            {
+                out = input;
             }
         }
 
@@ -34,15 +287,16 @@ class NeuralNetwork
         {
             for(auto& ws : weights)
             {
-                ws.fillRandom();
+                ws.fillRandom(rng);
 
                 ws *= sqrt(2.0 / ws.getRows());
             }
         }
 
     public:
-        NeuralNetwork(const std::vector<Layer>& network_layers)
-        : layers(network_layers)
+        NeuralNetwork(const std::vector<Layer>& network_layers,
+                      unsigned int seed = std::random_device{}())
+        : layers(network_layers), rng(seed)
         {
             connect_layers();
             initializeWeights();
@@ -55,23 +309,12 @@ class NeuralNetwork
                 throw std::runtime_error("Input size mismatch !");
             }
 
-            layers[0].a = input;
+            normalizeInput(input, layers[0].a);
 
             for (size_t l = 0; l < layers.size() - 1;++l)
             {
                 //weights.size() = layers.size() - 1
-                for (size_t j = 0; j < weights[l].getCols();++j)
-                {
-                    double sum = layers[l + 1].bias[j];
-
-                    for (size_t i = 0; i < weights[l].getRows();++i)
-                    {
-                        sum += layers[l].a[i] * weights[l](i, j);
-                    }
-
-                    layers[l + 1].z[j] = sum;
-                    layers[l + 1].a[j] = layers[l + 1].applyActivation(sum);
-                }
+                propagateLayer(l, layers[l].a, layers[l + 1].z, layers[l + 1].a);
             }
 
             return layers.back().a;
@@ -79,143 +322,512 @@ class NeuralNetwork
 
         std::vector<double> predict(const std::vector<double>& input)
         {
-            return forward(input);
+            if (!prediction_cache)
+            {
+                return forward(input);
+            }
+            thread_local PredictionCache::Key key;
+            std::vector<double> output;
+            bool cacheable = prediction_cache->makeKey(input, key);
+            if (cacheable && prediction_cache->lookup(key, output))
+            {
+                return output;
+            }
+            output = forward(input);
+            if (cacheable)
+            {
+                prediction_cache->insert(key, output);
+            }
+            return output;
+        }
+
+        // Cached infer(), safe to call from many threads on a const network
+        std::vector<double> predict(const std::vector<double>& input, InferenceWorkspace& ws) const
+        {
+            if (!prediction_cache)
+            {
+                return infer(input, ws);
+            }
+            thread_local PredictionCache::Key key;
+            std::vector<double> output;
+            bool cacheable = prediction_cache->makeKey(input, key);
+            if (cacheable && prediction_cache->lookup(key, output))
+            {
+                return output;
+            }
+            output = infer(input, ws);
+            if (cacheable)
+            {
+                prediction_cache->insert(key, output);
+            }
+            return output;
+        }
+
+        // Put a cache of `slots` entries in front of predict(). Frames are keyed
+        // after rounding every reading to `resolution`, so frames that differ by
+        // less than the sensors can resolve share one answer. Any change to the
+        // weights or the input normalization empties it.
+        void enablePredictionCache(size_t slots = 4096, double resolution = 0.001)
+        {
+            prediction_cache.emplace(layers.front().size, layers.back().size, slots, resolution);
+        }
+
+        void disablePredictionCache() { prediction_cache.reset(); }
+
+        PredictionCache* getPredictionCache() const
+        {
+            return prediction_cache ? &*prediction_cache : nullptr;
+        }
+
+        // Same result as forward() but leaves the network untouched, so any
+        // number of threads can share one const network (one workspace each)
+        const std::vector<double>& infer(const std::vector<double>& input,
+                                         InferenceWorkspace& ws) const
+        {
+            if(input.size() != static_cast<size_t>(layers[0].size))
+            {
+                throw std::runtime_error("Input size mismatch !");
+            }
+
+            ws.z.resize(layers.size());
+            ws.a.resize(layers.size());
+            for (size_t l = 0; l < layers.size(); ++l)
+            {
+                ws.z[l].resize(layers[l].size);
+                ws.a[l].resize(layers[l].size);
+            }
+
+            normalizeInput(input, ws.a[0]);
+            for (size_t l = 0; l < layers.size() - 1;++l)
+            {
+                propagateLayer(l, ws.a[l], ws.z[l + 1], ws.a[l + 1]);
+            }
+
+            return ws.a.back();
+        }
+
+        const std::vector<Layer>& getLayers() const { return layers; }
+        const std::vector<Matrix>& getWeights() const { return weights; }
+
+        // "CE" for a softmax head, "BCE" for sigmoid outputs
+        const char* lossName() const
+        {
+            return layers.back().isSoftmax() ? "CE" : "BCE";
         }
 
+        // Train on standardized inputs: pass the per-feature statistics of the
+        // training split (see CSV::computeFeatureStats) before calling train()
+        void setInputNormalization(const std::vector<double>& mean,
+                                   const std::vector<double>& stddev)
+        {
+            if (mean.size() != static_cast<size_t>(layers[0].size) || stddev.size() != mean.size())
+            {
+                throw std::runtime_error("Normalization size doesn't match the input layer !");
+            }
+            input_mean = mean;
+            input_stddev = stddev;
+            normalization_folded = false;
+            invalidatePredictionCache();
+        }
+
+        // Fold the input normalization into weights[0] and the layer 1 biases so
+        // that raw inputs give the same output and inference pays nothing for it:
+        //   w'(i,j) = w(i,j) / stddev[i]
+        //   b'[j]   = b[j] - sum_i w(i,j) * mean[i] / stddev[i]
+        // A convolution's kernels are shared by all sensors, so per-sensor scaling
+        // can't be folded into them; such networks keep normalizing in forward().
+        void foldInputNormalization()
+        {
+            if (input_mean.empty() || normalization_folded || layers[1].isConv())
+            {
+                return;
+            }
+            foldNormalization(weights[0], layers[1].bias);
+            normalization_folded = true;
+            invalidatePredictionCache();
+        }
+
+        // Inverse of foldInputNormalization: gets a loaded model back to training on
+        // standardized inputs, which keeps further SGD updates well conditioned
+        void unfoldInputNormalization()
+        {
+            if (input_mean.empty() || !normalization_folded || layers[1].isConv())
+            {
+                return;
+            }
+            for (size_t j = 0; j < weights[0].getCols(); ++j)
+            {
+                double shift = 0.0;
+                for (size_t i = 0; i < weights[0].getRows(); ++i)
+                {
+                    shift += weights[0](i, j) * input_mean[i];
+                    weights[0](i, j) *= input_stddev[i];
+                }
+                layers[1].bias[j] += shift;
+            }
+            normalization_folded = false;
+            invalidatePredictionCache();
+        }
+
+        bool hasInputNormalization() const { return !input_mean.empty(); }
+        bool isNormalizationFolded() const { return normalization_folded; }
+
         void train(const std::vector<std::vector<double>>& inputs,
                 const std::vector<std::vector<double>>& targets,
                 double learning_rate,
                 size_t epochs , 
                 size_t batch_size = 1,
+                bool verbose = true,
+                CheckpointWriter* checkpointer = nullptr,
+                size_t checkpoint_every = 100)
+        {
+            if (learning_rate <= 0.0 || epochs <= 0 || batch_size <= 0) {
+                throw std::runtime_error("Learning rate, epochs, and batch size must be positive.");
+            }
+
+            LearningRateSchedule schedule;
+            schedule.base_lr = learning_rate;
+
+            runEpochs(inputs, targets, allSamples(inputs.size()), schedule, 0, epochs, batch_size, verbose,
+                      checkpointer, checkpoint_every);
+        }
+
+        // Train on a view of the dataset: only inputs[indices[..]] are used, in
+        // that order (e.g. the training folds of a cross-validation split)
+        void train(const std::vector<std::vector<double>>& inputs,
+                const std::vector<std::vector<double>>& targets,
+                const std::vector<size_t>& indices,
+                double learning_rate,
+                size_t epochs,
+                size_t batch_size = 1,
                 bool verbose = true)
+        {
+            if (learning_rate <= 0.0 || epochs <= 0 || batch_size <= 0 || indices.empty()) {
+                throw std::runtime_error("Learning rate, epochs, batch size and indices must be positive.");
+            }
+            for (size_t k : indices)
+            {
+                if (k >= inputs.size())
+                {
+                    throw std::out_of_range("Training index out of range");
+                }
+            }
+
+            LearningRateSchedule schedule;
+            schedule.base_lr = learning_rate;
+
+            runEpochs(inputs, targets, indices, schedule, 0, epochs, batch_size, verbose, nullptr, 0);
+        }
+
+        // Continue an interrupted train() run from a checkpoint file.
+        // Given the same inputs the result is bit-identical to an uninterrupted run.
+        bool resumeTraining(const std::vector<std::vector<double>>& inputs,
+                            const std::vector<std::vector<double>>& targets,
+                            const std::string& checkpoint_file = "checkpoint.csv",
+                            bool verbose = true,
+                            CheckpointWriter* checkpointer = nullptr,
+                            size_t checkpoint_every = 100)
+        {
+            TrainingCheckpoint ckpt;
+            if (!Checkpoint::read(checkpoint_file, ckpt))
+            {
+                return false;
+            }
+            restoreCheckpoint(ckpt);
+
+            if (verbose)
+            {
+                std::stringstream data;
+                data << "Resuming training from " << checkpoint_file
+                    << " at epoch " << ckpt.next_epoch << " of " << ckpt.epochs << "\n";
+                std::cout << data.str();
+                L::log(data.str());
+            }
+
+            runEpochs(inputs, targets, allSamples(inputs.size()), ckpt.schedule, ckpt.next_epoch, ckpt.epochs,
+                      ckpt.batch_size, verbose, checkpointer, checkpoint_every);
+            return true;
+        }
+
+        // Single minibatch update on selected samples (used for online learning).
+        // Returns the mean loss (BCE, or CE for a softmax head) of the batch before the update.
+        double trainOnBatch(const std::vector<std::vector<double>>& inputs,
+                            const std::vector<std::vector<double>>& targets,
+                            const std::vector<size_t>& batch,
+                            double learning_rate)
+        {
+            if (batch.empty() || learning_rate <= 0.0)
+            {
+                throw std::runtime_error("Batch must be non-empty and learning rate positive.");
+            }
+            for (size_t k : batch)
+            {
+                if (k >= inputs.size() || k >= targets.size())
+                {
+                    throw std::out_of_range("Batch index out of range");
+                }
+            }
+            return trainBatch(inputs, targets, batch.data(), batch.size(), learning_rate) / batch.size();
+        }
+
+        void captureCheckpoint(TrainingCheckpoint& ckpt, size_t next_epoch, size_t epochs,
+                               size_t batch_size, const LearningRateSchedule& schedule) const
+        {
+            ckpt.next_epoch = next_epoch;
+            ckpt.epochs = epochs;
+            ckpt.batch_size = batch_size;
+            ckpt.schedule = schedule;
+
+            std::ostringstream rng_state;
+            rng_state << rng;
+            ckpt.rng_state = rng_state.str();
+
+            ckpt.input_mean = input_mean;
+            ckpt.input_stddev = input_stddev;
+            ckpt.normalization_folded = normalization_folded;
+
+            ckpt.weights = weights;
+            ckpt.biases.resize(layers.size() - 1);
+            for (size_t l = 1; l < layers.size(); ++l)
+            {
+                ckpt.biases[l - 1] = layers[l].bias;
+            }
+        }
+
+        void restoreCheckpoint(const TrainingCheckpoint& ckpt)
+        {
+            if (ckpt.weights.size() != weights.size())
+            {
+                throw std::runtime_error("Checkpoint topology doesn't match the network !");
+            }
+            for (size_t l = 0; l < weights.size(); ++l)
+            {
+                if (ckpt.weights[l].getRows() != weights[l].getRows() ||
+                    ckpt.weights[l].getCols() != weights[l].getCols() ||
+                    ckpt.biases[l].size() != layers[l + 1].bias.size())
+                {
+                    throw std::runtime_error("Checkpoint topology doesn't match the network !");
+                }
+            }
+
+            if (!ckpt.input_mean.empty())
+            {
+                setInputNormalization(ckpt.input_mean, ckpt.input_stddev);
+            }
+            else
+            {
+                input_mean.clear();
+                input_stddev.clear();
+            }
+            normalization_folded = ckpt.normalization_folded;
+
+            weights = ckpt.weights;
+            for (size_t l = 1; l < layers.size(); ++l)
+            {
+                layers[l].bias = ckpt.biases[l - 1];
+            }
+
+            std::istringstream rng_state(ckpt.rng_state);
+            rng_state >> rng;
+            invalidatePredictionCache();
+        }
+
+    private:
+        void foldNormalization(Matrix& first_weights, std::vector<double>& first_bias) const
+        {
+            for (size_t j = 0; j < first_weights.getCols(); ++j)
+            {
+                double shift = 0.0;
+                for (size_t i = 0; i < first_weights.getRows(); ++i)
+                {
+                    first_weights(i, j) /= input_stddev[i];
+                    shift += first_weights(i, j) * input_mean[i];
+                }
+                first_bias[j] -= shift;
+            }
+        }
+
+        // One SGD step on the samples inputs[batch[0..actual_batch_size)],
+        // returns the summed loss of the batch (before the update)
+        double trainBatch(const std::vector<std::vector<double>>& inputs,
+                          const std::vector<std::vector<double>>& targets,
+                          const size_t* batch,
+                          size_t actual_batch_size,
+                          double learning_rate)
+        {
+            double batchError = 0.0;
+
+            size_t widest = 0;
+            for (const Layer& layer : layers)
+            {
+                widest = std::max(widest, static_cast<size_t>(layer.size));
+            }
+            std::vector<double> error(widest, 0.0);
+            std::vector<double> target(layers.back().size, 0.0);
+
+            std::vector<Matrix> weight_batch_gradients;
+            for (size_t i = 0; i < weights.size(); ++i)
+            {
+                weight_batch_gradients.emplace_back(weights[i].getRows(), weights[i].getCols());
+            }
+            std::vector<std::vector<double>> bias_batch_gradients(layers.size()-1);
+            for (size_t i = 0; i < bias_batch_gradients.size();++i)
+            {
+                bias_batch_gradients[i].resize(layers[i + 1].bias.size(), 0.0);
+            }
+
+            for (size_t b = 0; b < actual_batch_size; ++b)
+            {
+                size_t k = batch[b];
+                forward(inputs[k]);
+                //compute Gradients
+                //compute the outputGradients
+                Layer &outputLayer = layers.back();
+                const double epsilon = 1e-7;
+                if (outputLayer.isSoftmax())
+                {
+                    // Targets are one-hot, or a single class index
+                    if (targets[k].size() == target.size())
+                    {
+                        target = targets[k];
+                    }
+                    else
+                    {
+                        // Range check the double first: casting NaN or a negative is undefined
+                        double index = targets[k].empty() ? -1.0 : targets[k][0];
+                        if (targets[k].size() != 1 || !std::isfinite(index) ||
+                            index < 0.0 || index >= static_cast<double>(target.size()))
+                        {
+                            throw std::runtime_error("Softmax target must be one-hot or a class index !");
+                        }
+                        std::fill(target.begin(), target.end(), 0.0);
+                        target[static_cast<size_t>(index)] = 1.0;
+                    }
+                    // Fused softmax + cross-entropy: gradient w.r.t. the logits is p - y
+                    batchError += Activation::softmaxCrossEntropy(outputLayer.z.data(), target.data(),
+                                                                  outputLayer.a.data(),
+                                                                  outputLayer.gradient.data(),
+                                                                  target.size());
+                }
+                else
+                {
+                    for (size_t i = 0; i < outputLayer.size;++i)
+                    {
+                        double y_true = targets[k][i];
+                        double y_pred = outputLayer.a[i];
+
+                        // Clamp y_pred to avoid log(0)
+                        y_pred = std::min(std::max(y_pred, epsilon), 1.0 - epsilon);
+
+                        // Binary cross-entropy loss
+                        //L=−(ylog( y ^ ​ )+(1−y)log(1− y ^ ​ ))
+                        batchError += - (y_true * std::log(y_pred) + (1.0 - y_true) * std::log(1.0 - y_pred));
+
+                        // Gradient: derivative of BCE w/ sigmoid output
+                        outputLayer.gradient[i] = y_pred - y_true;
+                    }
+                }
+                //compute other layers Gradients
+                for (int l = (static_cast<int>(layers.size()) - 2); l > 0;--l)
+                {
+                    backpropagateError(l, error);
+                    for (size_t i = 0; i < layers[l].size;++i)
+                    {
+                        layers[l].gradient[i] = error[i] *
+                            layers[l].applyActivationDerivative(layers[l].z[i]);
+                    }
+                }
+                //Accumulate gradients
+                for (int l = (static_cast<int>(layers.size()) - 2); l >= 0;--l)
+                {
+                    // layers[0].a holds the (normalized) input of this sample
+                    //bias_batch_gradients size is (layer - 1 )
+                    //(EX: for 4 layers it is 3 it means for l: 2 to 0 bias_batch_gradients[l])
+                    accumulateGradients(l, weight_batch_gradients[l], bias_batch_gradients[l]);
+                }
+
+                //end of batch loop
+            }
+
+            //update the weights and biases
+            for (int l = (static_cast<int>(layers.size()) - 2); l >= 0;--l)
+            {
+                for (size_t i = 0; i < weights[l].getRows();++i)
+                {
+                    for (size_t j = 0;j < weights[l].getCols();++j)
+                    {
+                        weights[l](i, j) -= learning_rate * (weight_batch_gradients[l](i,j) / actual_batch_size);
+                    }
+
+                }
+
+                for (size_t i = 0; i < layers[l+1].bias.size();++i)
+                {
+                    layers[l+1].bias[i] -= learning_rate * (bias_batch_gradients[l][i] / actual_batch_size);
+                }
+            }
+            invalidatePredictionCache();
+
+            return batchError;
+        }
+
+        static std::vector<size_t> allSamples(size_t count)
+        {
+            std::vector<size_t> order(count);
+            std::iota(order.begin(), order.end(), 0);
+            return order;
+        }
+
+        // Samples are visited in the given order every epoch
+        void runEpochs(const std::vector<std::vector<double>>& inputs,
+                const std::vector<std::vector<double>>& targets,
+                const std::vector<size_t>& order,
+                const LearningRateSchedule& schedule,
+                size_t start_epoch,
+                size_t epochs,
+                size_t batch_size,
+                bool verbose,
+                CheckpointWriter* checkpointer,
+                size_t checkpoint_every)
         {
             if(inputs.size() != targets.size())
             {
                 throw std::runtime_error("Input and Target sizes don't match !");
             }
-            if (learning_rate <= 0.0 || epochs <= 0 || batch_size <= 0) {
-                throw std::runtime_error("Learning rate, epochs, and batch size must be positive.");
-            }
 
-            size_t dataset_size = inputs.size();
+            size_t dataset_size = order.size();
             auto start = std::chrono::high_resolution_clock::now();
             double totalError = 0.0;
-            double base_lr = learning_rate;
-            double decay_rate = 0.996; // decay by 0.4% each epoch
-            double min_lr = 1e-4;      // prevent it from vanishing
+            double learning_rate = schedule.at(start_epoch);
             if(verbose){
                 std::stringstream data;
                 data << "---------------------training info-------------------\n";
-                data << "learning_rate = " << learning_rate
-                    << "\t learning rate decay rate = "<<(1.0 - decay_rate)*100<<"%"
+                data << "learning_rate = " << schedule.base_lr
+                    << "\t learning rate decay rate = "<<(1.0 - schedule.decay_rate)*100<<"%"
                     << "\t EPOCHS = " << epochs <<"\n";
 
                 data << "dataset size = " << dataset_size 
                     << "\t batch size = " << batch_size << "\n";
+                if (checkpointer)
+                {
+                    data << "checkpoint every " << checkpoint_every
+                        << " epochs to " << checkpointer->getFilename() << "\n";
+                }
                 data << "\n--------------------training ... ------------------\n";            
                 std::cout << data.str();
                 L::log(data.str());
             }
             
 
-            for (int epoch = 0; epoch < epochs;++epoch)
+            for (size_t epoch = start_epoch; epoch < epochs;++epoch)
             {
-                learning_rate = std::max(min_lr, base_lr * std::pow(decay_rate, epoch));
+                learning_rate = schedule.at(epoch);
                 totalError = 0.0;
 
                 for (size_t batch = 0; batch < dataset_size; batch += batch_size)
                 {
                     size_t actual_batch_size = std::min(batch_size, (dataset_size - batch));
-
-                    std::vector<Matrix> weight_batch_gradients;
-                    for (size_t i = 0; i < weights.size(); ++i)
-                    {
-                        weight_batch_gradients.emplace_back(weights[i].getRows(), weights[i].getCols());
-                    }
-                    std::vector<std::vector<double>> bias_batch_gradients(layers.size()-1);
-                    for (size_t i = 0; i < bias_batch_gradients.size();++i)
-                    {
-                        bias_batch_gradients[i].resize(layers[i + 1].size, 0.0);
-                    }
-
-                    for (size_t k = batch; k < (batch + actual_batch_size); ++k)
-                    {
-                        forward(inputs[k]);
-                        //compute Gradients
-                        //compute the outputGradients
-                        Layer &outputLayer = layers.back();
-                        const double epsilon = 1e-7;
-                        for (size_t i = 0; i < outputLayer.size;++i)
-                        {
-                            double y_true = targets[k][i];
-                            double y_pred = outputLayer.a[i];
-
-                            // Clamp y_pred to avoid log(0)
-                            y_pred = std::min(std::max(y_pred, epsilon), 1.0 - epsilon);
-
-                            // Binary cross-entropy loss
-                            //L=−(ylog( y ^ ​ )+(1−y)log(1− y ^ ​ ))
-                            totalError += - (y_true * std::log(y_pred) + (1.0 - y_true) * std::log(1.0 - y_pred));
-
-                            // Gradient: derivative of BCE w/ sigmoid output
-                            outputLayer.gradient[i] = y_pred - y_true;
-                        }
-                        //compute other layers Gradients
-                        for (int l = (static_cast<int>(layers.size()) - 2); l > 0;--l)
-                        {
-                            for (size_t i = 0; i < weights[l].getRows();++i)
-                            {
-                                double error = 0.0;
-                                for (size_t j = 0;j < weights[l].getCols();++j)
-                                {
-                                    error += layers[l+1].gradient[j] * weights[l](i, j);
-                                }
-                                layers[l].gradient[i] = error *
-                                    layers[l].applyActivationDerivative(layers[l].z[i]);
-                            }
-                        }
-                        //Accumulate gradients
-                        for (int l = (static_cast<int>(layers.size()) - 2); l >= 0;--l)
-                        {
-                            const std::vector<double>& activations = (l == 0) ? inputs[k] : layers[l].a;
-
-                            for (size_t i = 0; i < weight_batch_gradients[l].getRows();++i)
-                            {
-                                for (size_t j = 0;j < weight_batch_gradients[l].getCols();++j)
-                                {
-                                    weight_batch_gradients[l](i, j) += layers[l+1].gradient[j] * activations[i];
-                                }
-                            }
-
-                            for (size_t i = 0; i < layers[l+1].size; ++i)
-                            {
-                                //bias_batch_gradients size is (layer - 1 )
-                                //(EX: for 4 layers it is 3 it means for l: 2 to 0 bias_batch_gradients[l])
-                                bias_batch_gradients[l][i] += layers[l+1].gradient[i];
-                            }
-                        }
-
-                        //end of batch loop
-                    }
-
-                    //update the weights and biases
-                    for (int l = (static_cast<int>(layers.size()) - 2); l >= 0;--l)
-                    {
-                        for (size_t i = 0; i < weights[l].getRows();++i)
-                        {
-                            for (size_t j = 0;j < weights[l].getCols();++j)
-                            {
-                                weights[l](i, j) -= learning_rate * (weight_batch_gradients[l](i,j) / actual_batch_size);
-                            }
-                        
-                        }
-
-                        for (size_t i = 0; i < layers[l+1].size;++i)
-                        {
-                            layers[l+1].bias[i] -= learning_rate * (bias_batch_gradients[l][i] / actual_batch_size);
-                        }
-                    }
-                    /////////////
+                    totalError += trainBatch(inputs, targets, &order[batch], actual_batch_size, learning_rate);
                 }
                 if(verbose && epoch % 100 == 0)
                 {
@@ -223,11 +835,17 @@ class NeuralNetwork
                     
                     data << "["
                     << (100 * epoch / epochs) << "%] EPOCH : " << epoch
-                    << " | BCE: " << totalError / inputs.size() << "\n";
+                    << " | " << lossName() << ": " << totalError / dataset_size << "\n";
                     std::cout << data.str();
                     L::log(data.str());
                     
                 }
+                if (checkpointer && checkpoint_every > 0 && (epoch + 1) % checkpoint_every == 0)
+                {
+                    checkpointer->submit([&](TrainingCheckpoint& ckpt) {
+                        captureCheckpoint(ckpt, epoch + 1, epochs, batch_size, schedule);
+                    });
+                }
             }
             auto end = std::chrono::high_resolution_clock::now();
             if(verbose)
@@ -235,7 +853,7 @@ class NeuralNetwork
                 
                 std::stringstream data;
                 data << "-------------------training done---------------------\n";
-                data << "Final BCE : " << totalError / inputs.size() << "\n";
+                data << "Final " << lossName() << " : " << totalError / dataset_size << "\n";
                 data << "Training Time : "
                 << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
                 << " ms\n";
@@ -244,45 +862,101 @@ class NeuralNetwork
             }
         }
 
+    public:
         void saveModel(const std::string& filename = "model.csv") const {
-            std::ofstream file(filename);
+            // Written next to the target and renamed over it when complete, so a
+            // process watching the file (see ModelServer) never reads half a model
+            const std::string tmp_filename = filename + ".tmp";
+            std::ofstream file(tmp_filename);
             if (!file.is_open()) {
-                std::cerr << "Unable to open file: " << filename << std::endl;
+                std::cerr << "Unable to open file: " << tmp_filename << std::endl;
                 return;
             }
 
+            file << std::setprecision(std::numeric_limits<double>::max_digits10);
             file << "type,layer,row,col,value\n"; // header
 
+            // The exported model takes raw inputs: an unfolded normalization is
+            // folded into a dense first layer on the way out
+            Matrix first_weights = weights[0];
+            std::vector<double> first_bias = layers[1].bias;
+            bool folded = normalization_folded;
+            if (!input_mean.empty() && !normalization_folded && !layers[1].isConv())
+            {
+                foldNormalization(first_weights, first_bias);
+                folded = true;
+            }
+
+            // Reference only when folded; a convolution first layer still needs them
+            for (size_t i = 0; i < input_mean.size(); ++i)
+            {
+                file << "mean,0," << i << ",0," << input_mean[i] << "\n";
+                file << "stddev,0," << i << ",0," << input_stddev[i] << "\n";
+            }
+            if (!input_mean.empty() && !folded)
+            {
+                file << "normalization_folded,0,0,0,0\n";
+            }
+
             for (size_t l = 1; l < layers.size();++l)
             {
-                for (size_t i = 0; i < weights[l-1].getRows();++i)
+                const Matrix& w = (l == 1) ? first_weights : weights[l-1];
+                const std::vector<double>& b = (l == 1) ? first_bias : layers[l].bias;
+
+                for (size_t i = 0; i < w.getRows();++i)
                 {
-                    for (size_t j = 0; j < weights[l-1].getCols();++j)
+                    for (size_t j = 0; j < w.getCols();++j)
                     {
-                        file << "weight," << l << "," << i << "," << j << "," <<  weights[l-1](i,j) << "\n";
+                        file << "weight," << l << "," << i << "," << j << "," <<  w(i,j) << "\n";
                     }
                 }
 
-                for (size_t i = 0; i < layers[l].bias.size();++i)
+                for (size_t i = 0; i < b.size();++i)
                 {
-                    file << "bias," << l << "," << i << ",0," << layers[l].bias[i] << "\n";
+                    file << "bias," << l << "," << i << ",0," << b[i] << "\n";
                 }
             }
 
             file.close();
+
+            std::error_code ec;
+            std::filesystem::rename(tmp_filename, filename, ec);
+            if (ec) {
+                std::cerr << "Unable to replace model file: " << filename << std::endl;
+                return;
+            }
             std::cout << "Model saved to " << filename << std::endl;
         }
 
-        void loadModel(const std::string& filename = "model.csv") {
+        // Returns false if the file is missing, doesn't fit this topology or
+        // doesn't cover every parameter
+        bool loadModel(const std::string& filename = "model.csv") {
             std::ifstream file(filename);
             if (!file.is_open()) {
                 std::cerr << "Unable to open model file: " << filename << std::endl;
-                return;
+                return false;
+            }
+
+            size_t expected = 0, loaded = 0;
+            for (size_t l = 1; l < layers.size(); ++l)
+            {
+                expected += weights[l-1].getRows() * weights[l-1].getCols() + layers[l].bias.size();
+            }
+
+            // Parse into copies; the live parameters only change once the whole
+            // file has been accepted
+            std::vector<Matrix> new_weights = weights;
+            std::vector<std::vector<double>> new_bias(layers.size());
+            for (size_t l = 1; l < layers.size(); ++l)
+            {
+                new_bias[l] = layers[l].bias;
             }
 
             std::string line;
             std::getline(file, line); // Skip header
 
+            std::vector<double> mean, stddev;
+            bool folded = true;
             while (std::getline(file, line)) {
                 std::stringstream ss(line);
                 std::string type, layerStr, rowStr, colStr, valueStr;
@@ -293,20 +967,69 @@ class NeuralNetwork
                 std::getline(ss, colStr, ',');
                 std::getline(ss, valueStr, ',');
 
-                int layer = std::stoi(layerStr);
-                int row = std::stoi(rowStr);
-                int col = std::stoi(colStr);
-                double value = std::stod(valueStr);
+                int layer, row, col;
+                double value;
+                try {
+                    layer = std::stoi(layerStr);
+                    row = std::stoi(rowStr);
+                    col = std::stoi(colStr);
+                    value = std::stod(valueStr);
+                } catch (const std::exception&) {
+                    std::cerr << "Malformed model file: " << filename << std::endl;
+                    return false;
+                }
 
+                bool in_layers = layer >= 1 && layer < static_cast<int>(layers.size()) && row >= 0 && col >= 0;
                 if (type == "weight") {
-                    weights[layer-1](row, col) = value;
+                    if (!in_layers ||
+                        static_cast<size_t>(row) >= weights[layer-1].getRows() ||
+                        static_cast<size_t>(col) >= weights[layer-1].getCols()) {
+                        std::cerr << "Model file doesn't match the network topology: " << filename << std::endl;
+                        return false;
+                    }
+                    new_weights[layer-1](row, col) = value;
+                    ++loaded;
                 } else if (type == "bias") {
-                    layers[layer].bias[row] = value;
+                    if (!in_layers || static_cast<size_t>(row) >= layers[layer].bias.size()) {
+                        std::cerr << "Model file doesn't match the network topology: " << filename << std::endl;
+                        return false;
+                    }
+                    new_bias[layer][row] = value;
+                    ++loaded;
+                } else if (type == "mean") {
+                    mean.push_back(value);
+                } else if (type == "stddev") {
+                    stddev.push_back(value);
+                } else if (type == "normalization_folded") {
+                    folded = value != 0.0;
                 }
             }
 
+            // normalizeInput and unfoldInputNormalization index these by input
+            if (mean.size() != stddev.size() ||
+                (!mean.empty() && mean.size() != static_cast<size_t>(layers[0].size))) {
+                std::cerr << "Input normalization doesn't match the input layer: " << filename << std::endl;
+                return false;
+            }
+
             file.close();
+            if (loaded != expected) {
+                std::cerr << "Incomplete model file: " << filename << std::endl;
+                return false;
+            }
+
+            weights = std::move(new_weights);
+            for (size_t l = 1; l < layers.size(); ++l)
+            {
+                layers[l].bias = std::move(new_bias[l]);
+            }
+            // Saved weights take raw inputs unless the file says otherwise
+            input_mean = mean;
+            input_stddev = stddev;
+            normalization_folded = folded;
+            invalidatePredictionCache();
             std::cout << "Model loaded from " << filename << std::endl;
+            return true;
         }
 
 };
@@ -0,0 +1,313 @@
+/*
+author : @rebwar_ai
+*/
+#ifndef ONLINE_LEARNER_HPP
+#define ONLINE_LEARNER_HPP
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <string>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <sstream>
+#include <cmath>
+#include "NeuralNetwork.hpp"
+#include "ModelServer.hpp"
+#include "Log.hpp"
+
+struct OnlineLearningConfig {
+    size_t replay_capacity = 2048;   // most recent frames kept for replay
+    size_t min_replay_size = 64;     // no updates until this many frames are seen
+    size_t batch_size = 16;
+    size_t updates_per_frame = 1;    // minibatch steps per newly arrived frame
+    size_t max_updates_per_wakeup = 256; // caps the catch-up work after a burst
+    double learning_rate = 0.005;    // small: we are fine tuning, not training
+    size_t publish_every = 50;       // updates between snapshots sent to the server
+    unsigned int seed = 42;
+};
+
+// Fixed size ring of labelled frames; once full the oldest frame is overwritten
+class ReplayBuffer
+{
+    private:
+        size_t capacity;
+        size_t next = 0;
+        std::vector<std::vector<double>> features;
+        std::vector<std::vector<double>> labels;
+
+    public:
+        explicit ReplayBuffer(size_t capacity)
+        : capacity(capacity)
+        {
+            if (capacity == 0)
+            {
+                throw std::invalid_argument("Replay buffer capacity must be positive !");
+            }
+            features.reserve(capacity);
+            labels.reserve(capacity);
+        }
+
+        void add(std::vector<double> frame, std::vector<double> label)
+        {
+            if (features.size() < capacity)
+            {
+                features.push_back(std::move(frame));
+                labels.push_back(std::move(label));
+            }
+            else
+            {
+                features[next] = std::move(frame);
+                labels[next] = std::move(label);
+            }
+            next = (next + 1) % capacity;
+        }
+
+        // Uniform sample with replacement
+        void sample(size_t batch_size, std::mt19937& gen, std::vector<size_t>& batch) const
+        {
+            std::uniform_int_distribution<size_t> dist(0, features.size() - 1);
+            batch.resize(batch_size);
+            for (size_t& k : batch)
+            {
+                k = dist(gen);
+            }
+        }
+
+        size_t size() const { return features.size(); }
+        const std::vector<std::vector<double>>& getFeatures() const { return features; }
+        const std::vector<std::vector<double>>& getLabels() const { return labels; }
+};
+
+// Keeps adapting a trained model to newly labelled frames on a background thread.
+// Producers call submit() as frames arrive; the worker moves them into the replay
+// buffer and runs small minibatch updates. Inference keeps going through the
+// ModelServer, which receives a fresh snapshot every publish_every updates.
+// At most replay_capacity frames wait for the worker: older ones would be
+// overwritten in the ring anyway, so when producers outrun SGD the oldest
+// pending frames are dropped.
+class OnlineLearner
+{
+    private:
+        NeuralNetwork network;
+        OnlineLearningConfig config;
+        ModelServer* server;
+        const size_t input_size, output_size;
+        const bool softmax;
+
+        ReplayBuffer replay;
+        std::mt19937 gen;
+
+        std::deque<std::pair<std::vector<double>, std::vector<double>>> incoming;
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::thread worker;
+        bool running = false;
+        bool stopping = false;
+
+        size_t frames_seen = 0;
+        size_t frames_dropped = 0;
+        size_t updates = 0;
+        double recent_loss = 0.0;
+
+        void publishSnapshot()
+        {
+            if (!server)
+            {
+                return;
+            }
+            // Serve the folded copy so predictions skip input normalization
+            NeuralNetwork snapshot = network;
+            snapshot.foldInputNormalization();
+            server->publish(snapshot, "online");
+        }
+
+        void run()
+        {
+            std::vector<size_t> batch;
+            size_t since_publish = 0;
+
+            std::unique_lock<std::mutex> lock(mtx);
+            while (true)
+            {
+                cv.wait(lock, [this] { return !incoming.empty() || stopping; });
+                if (stopping)
+                {
+                    break;
+                }
+
+                size_t arrived = incoming.size();
+                while (!incoming.empty())
+                {
+                    replay.add(std::move(incoming.front().first), std::move(incoming.front().second));
+                    incoming.pop_front();
+                }
+                frames_seen += arrived;
+                lock.unlock();
+
+                // Training runs without the lock so producers never wait on it
+                size_t done = 0;
+                double loss = recent_loss;
+                if (replay.size() >= config.min_replay_size)
+                {
+                    size_t steps = std::min(arrived * config.updates_per_frame, config.max_updates_per_wakeup);
+                    try {
+                        for (size_t s = 0; s < steps; ++s)
+                        {
+                            replay.sample(config.batch_size, gen, batch);
+                            double batch_loss = network.trainOnBatch(replay.getFeatures(), replay.getLabels(),
+                                                                     batch, config.learning_rate);
+                            // Seed the moving average with the first batch, not 0
+                            loss = (updates + done == 0) ? batch_loss : 0.99 * loss + 0.01 * batch_loss;
+                            ++done;
+
+                            if (++since_publish >= config.publish_every)
+                            {
+                                publishSnapshot();
+                                since_publish = 0;
+                            }
+                        }
+                    } catch (const std::exception& e) {
+                        // Skip the rest of this round rather than terminate the host process
+                        std::stringstream data;
+                        data << "Online update failed: " << e.what() << "\n";
+                        std::cerr << data.str();
+                        L::log(data.str());
+                    }
+                }
+
+                lock.lock();
+                updates += done;
+                recent_loss = loss;
+            }
+
+            if (since_publish > 0)
+            {
+                publishSnapshot();
+            }
+        }
+
+    public:
+        // warm_start is usually a model restored with loadModel
+        OnlineLearner(const NeuralNetwork& warm_start,
+                      const OnlineLearningConfig& cfg = OnlineLearningConfig{},
+                      ModelServer* model_server = nullptr)
+        : network(warm_start), config(cfg), server(model_server),
+          input_size(warm_start.getLayers().front().size),
+          output_size(warm_start.getLayers().back().size),
+          softmax(warm_start.getLayers().back().isSoftmax()),
+          replay(cfg.replay_capacity), gen(cfg.seed)
+        {
+            if (config.batch_size == 0 || config.learning_rate <= 0.0)
+            {
+                throw std::invalid_argument("Batch size and learning rate must be positive !");
+            }
+            config.min_replay_size = std::max<size_t>(config.min_replay_size, 1);
+            config.max_updates_per_wakeup = std::max<size_t>(config.max_updates_per_wakeup, 1);
+            network.unfoldInputNormalization();
+        }
+
+        OnlineLearner(const OnlineLearner&) = delete;
+        OnlineLearner& operator=(const OnlineLearner&) = delete;
+
+        ~OnlineLearner()
+        {
+            stop();
+        }
+
+        void start()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (running)
+            {
+                return;
+            }
+            stopping = false;
+            running = true;
+            worker = std::thread(&OnlineLearner::run, this);
+        }
+
+        // Finishes the current update, publishes the latest weights and joins
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!running)
+                {
+                    return;
+                }
+                stopping = true;
+            }
+            cv.notify_all();
+            worker.join();
+
+            std::lock_guard<std::mutex> lock(mtx);
+            running = false;
+
+            std::stringstream data;
+            data << "Online learning stopped: " << frames_seen << " frames ("
+                << frames_dropped << " dropped), " << updates << " updates, recent " << network.lossName() << " " << recent_loss << "\n";
+            L::log(data.str());
+        }
+
+        // Called by the sensor thread for every labelled frame. The label is one
+        // value per output, or a single class index for a softmax network.
+        void submit(const std::vector<double>& frame, const std::vector<double>& label)
+        {
+            if (frame.size() != input_size)
+            {
+                throw std::invalid_argument("Frame size doesn't match the input layer !");
+            }
+            bool class_index = softmax && label.size() == 1 && std::isfinite(label[0])
+                && label[0] >= 0.0 && label[0] < static_cast<double>(output_size);
+            if (label.size() != output_size && !class_index)
+            {
+                throw std::invalid_argument("Label doesn't match the output layer !");
+            }
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (incoming.size() >= config.replay_capacity)
+                {
+                    incoming.pop_front();
+                    ++frames_dropped;
+                }
+                incoming.emplace_back(frame, label);
+            }
+            cv.notify_one();
+        }
+
+        // Only valid while the learner is stopped
+        const NeuralNetwork& getNetwork()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (running)
+            {
+                throw std::runtime_error("Stop the online learner before reading its network !");
+            }
+            return network;
+        }
+
+        size_t framesSeen()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            return frames_seen;
+        }
+
+        size_t framesDropped()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            return frames_dropped;
+        }
+
+        size_t updatesDone()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            return updates;
+        }
+};
+
+#endif // ONLINE_LEARNER_HPP
@@ -0,0 +1,313 @@
+/*
+author : @rebwar_ai
+*/
+#ifndef PREDICTION_CACHE_HPP
+#define PREDICTION_CACHE_HPP
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+// Fixed-size, lock-free cache of network outputs keyed by the input frame
+// quantized to the sensors' resolution (0.001 m in sensor_readings_24.csv), so
+// a stationary robot or a straight wall keeps hitting the same entries.
+//
+// Open addressing with linear probing over a window of PROBE_WINDOW slots and
+// CLOCK (second chance) eviction inside that window. Every slot is a seqlock:
+// a writer claims it by moving its sequence number from even to odd with one
+// CAS, readers copy the entry and drop it if the sequence moved meanwhile.
+// Nobody ever waits; a lost race only costs a miss or a skipped insert.
+//
+// clear() is O(1): it bumps the generation, and slots of older generations
+// count as empty.
+class PredictionCache
+{
+    public:
+        // Quantized frame and its hash, computed once per prediction
+        struct Key {
+            std::vector<int32_t> q;
+            uint64_t hash = 0;
+        };
+
+    private:
+        static constexpr size_t PROBE_WINDOW = 8;
+
+        struct Slot {
+            std::atomic<uint32_t> seq{0};           // odd while a writer owns the slot
+            std::atomic<uint32_t> generation{0};
+            std::atomic<uint64_t> hash{0};
+            std::atomic<uint8_t> referenced{0};     // CLOCK bit
+        };
+
+        size_t input_size, output_size;
+        size_t capacity, mask;
+        double resolution, inv_resolution;
+
+        std::unique_ptr<Slot[]> slots;
+        std::unique_ptr<std::atomic<int32_t>[]> keys;   // capacity x input_size
+        std::unique_ptr<std::atomic<double>[]> values;  // capacity x output_size
+
+        std::atomic<uint32_t> generation{1};
+        std::atomic<size_t> clock_hand{0};
+        std::atomic<uint64_t> hits{0}, misses{0}, inserts{0}, evictions{0};
+
+        static size_t roundUpPow2(size_t n)
+        {
+            size_t p = PROBE_WINDOW;
+            while (p < n) p <<= 1;
+            return p;
+        }
+
+        bool isLive(const Slot& slot, uint32_t gen) const
+        {
+            return slot.generation.load(std::memory_order_relaxed) == gen
+                && slot.hash.load(std::memory_order_relaxed) != 0;
+        }
+
+        bool tryClaim(Slot& slot, uint32_t& seq)
+        {
+            seq = slot.seq.load(std::memory_order_relaxed);
+            if ((seq & 1) || !slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire))
+            {
+                return false;
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+            return true;
+        }
+
+    public:
+        PredictionCache(size_t input_size, size_t output_size,
+                        size_t requested_slots = 4096, double resolution = 0.001)
+        : input_size(input_size), output_size(output_size),
+          capacity(roundUpPow2(requested_slots)), mask(capacity - 1),
+          resolution(resolution), inv_resolution(1.0 / resolution),
+          slots(new Slot[capacity]),
+          keys(new std::atomic<int32_t>[capacity * input_size]),
+          values(new std::atomic<double>[capacity * output_size])
+        {
+            if (input_size == 0 || output_size == 0 || !(resolution > 0.0))
+            {
+                throw std::invalid_argument("Invalid prediction cache configuration !");
+            }
+        }
+
+        // A copy starts empty with the same settings: the copied network's
+        // weights are free to diverge from the original's
+        PredictionCache(const PredictionCache& other)
+        : PredictionCache(other.input_size, other.output_size, other.capacity, other.resolution) {}
+
+        PredictionCache& operator=(const PredictionCache& other)
+        {
+            if (this != &other)
+            {
+                input_size = other.input_size;
+                output_size = other.output_size;
+                capacity = other.capacity;
+                mask = other.mask;
+                resolution = other.resolution;
+                inv_resolution = other.inv_resolution;
+                slots.reset(new Slot[capacity]);
+                keys.reset(new std::atomic<int32_t>[capacity * input_size]);
+                values.reset(new std::atomic<double>[capacity * output_size]);
+                generation = 1;
+                clock_hand = 0;
+                resetStats();
+            }
+            return *this;
+        }
+
+        // False when the frame can't be represented (NaN, out of range); such
+        // frames simply bypass the cache
+        bool makeKey(const std::vector<double>& input, Key& key) const
+        {
+            if (input.size() != input_size)
+            {
+                return false;
+            }
+            key.q.resize(input_size);
+            uint64_t h = 0x9E3779B97F4A7C15ull;
+            for (size_t i = 0; i < input_size; ++i)
+            {
+                double scaled = input[i] * inv_resolution;
+                if (!(std::fabs(scaled) < 2.0e9))
+                {
+                    return false;
+                }
+                // round half away from zero; a plain cast, no libm call
+                key.q[i] = static_cast<int32_t>(scaled + (scaled < 0.0 ? -0.5 : 0.5));
+                h = (h ^ static_cast<uint32_t>(key.q[i])) * 0x100000001B3ull;
+            }
+            // splitmix64 finalizer spreads the FNV state over the low bits we index with
+            h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ull;
+            h ^= h >> 27; h *= 0x94D049BB133111EBull;
+            h ^= h >> 31;
+            key.hash = h ? h : 1;   // 0 marks an empty slot
+            return true;
+        }
+
+        bool lookup(const Key& key, std::vector<double>& output)
+        {
+            const uint32_t gen = generation.load(std::memory_order_acquire);
+            output.resize(output_size);
+
+            for (size_t p = 0; p < PROBE_WINDOW; ++p)
+            {
+                const size_t s = (key.hash + p) & mask;
+                Slot& slot = slots[s];
+
+                uint32_t seq = slot.seq.load(std::memory_order_acquire);
+                if (seq & 1)
+                {
+                    continue;   // being written
+                }
+                if (slot.generation.load(std::memory_order_relaxed) != gen)
+                {
+                    break;      // empty: probing stops here within a generation
+                }
+                uint64_t h = slot.hash.load(std::memory_order_relaxed);
+                if (h == 0)
+                {
+                    break;
+                }
+                if (h != key.hash)
+                {
+                    continue;
+                }
+
+                bool same = true;
+                const std::atomic<int32_t>* k = &keys[s * input_size];
+                for (size_t i = 0; i < input_size && same; ++i)
+                {
+                    same = k[i].load(std::memory_order_relaxed) == key.q[i];
+                }
+                const std::atomic<double>* v = &values[s * output_size];
+                for (size_t j = 0; j < output_size; ++j)
+                {
+                    output[j] = v[j].load(std::memory_order_relaxed);
+                }
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (same && slot.seq.load(std::memory_order_relaxed) == seq)
+                {
+                    slot.referenced.store(1, std::memory_order_relaxed);
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        void insert(const Key& key, const std::vector<double>& output)
+        {
+            if (output.size() != output_size)
+            {
+                return;
+            }
+            const uint32_t gen = generation.load(std::memory_order_acquire);
+            const size_t base = key.hash & mask;
+
+            // First empty slot of the window, otherwise CLOCK: sweep from the
+            // hand, clearing reference bits until an unreferenced slot turns up
+            size_t victim = capacity;
+            for (size_t p = 0; p < PROBE_WINDOW && victim == capacity; ++p)
+            {
+                if (!isLive(slots[(base + p) & mask], gen))
+                {
+                    victim = (base + p) & mask;
+                }
+            }
+            bool evicting = (victim == capacity);
+            if (evicting)
+            {
+                size_t hand = clock_hand.fetch_add(1, std::memory_order_relaxed);
+                for (size_t p = 0; p < 2 * PROBE_WINDOW; ++p)
+                {
+                    size_t s = (base + (hand + p) % PROBE_WINDOW) & mask;
+                    if (slots[s].referenced.exchange(0, std::memory_order_relaxed) == 0)
+                    {
+                        victim = s;
+                        break;
+                    }
+                }
+                // Concurrent hits can set every bit again between the two passes;
+                // then evict the slot under the hand anyway
+                if (victim == capacity)
+                {
+                    victim = (base + hand % PROBE_WINDOW) & mask;
+                }
+            }
+
+            Slot& slot = slots[victim];
+            uint32_t seq;
+            if (!tryClaim(slot, seq))
+            {
+                return;     // another writer has it, don't wait
+            }
+
+            std::atomic<int32_t>* k = &keys[victim * input_size];
+            for (size_t i = 0; i < input_size; ++i)
+            {
+                k[i].store(key.q[i], std::memory_order_relaxed);
+            }
+            std::atomic<double>* v = &values[victim * output_size];
+            for (size_t j = 0; j < output_size; ++j)
+            {
+                v[j].store(output[j], std::memory_order_relaxed);
+            }
+            slot.hash.store(key.hash, std::memory_order_relaxed);
+            slot.generation.store(gen, std::memory_order_relaxed);
+            slot.referenced.store(0, std::memory_order_relaxed);
+            slot.seq.store(seq + 2, std::memory_order_release);
+
+            inserts.fetch_add(1, std::memory_order_relaxed);
+            if (evicting)
+            {
+                evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Drops every entry, e.g. once the weights behind them have changed
+        void clear()
+        {
+            generation.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        void resetStats()
+        {
+            hits = 0;
+            misses = 0;
+            inserts = 0;
+            evictions = 0;
+        }
+
+        uint64_t getHits() const { return hits.load(std::memory_order_relaxed); }
+        uint64_t getMisses() const { return misses.load(std::memory_order_relaxed); }
+        uint64_t getEvictions() const { return evictions.load(std::memory_order_relaxed); }
+        size_t getCapacity() const { return capacity; }
+        double getResolution() const { return resolution; }
+
+        double hitRate() const
+        {
+            uint64_t h = getHits(), total = h + getMisses();
+            return total == 0 ? 0.0 : static_cast<double>(h) / total;
+        }
+
+        std::string stats() const
+        {
+            std::stringstream data;
+            data << "Prediction cache: " << getHits() << " hits | " << getMisses() << " misses | "
+                << std::fixed << std::setprecision(2) << hitRate() * 100 << "% hit rate | "
+                << inserts.load(std::memory_order_relaxed) << " inserts | "
+                << getEvictions() << " evictions | " << capacity << " slots\n";
+            return data.str();
+        }
+};
+
+#endif // PREDICTION_CACHE_HPP
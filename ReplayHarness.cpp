@@ -0,0 +1,271 @@
+/*
+author : @rebwar_ai
+*/
+// Replays recorded sensor frames through the inference path at a realistic
+// arrival rate and reports per-frame latency percentiles and deadline misses.
+//
+// usage: ReplayHarness [--data sensor_readings_24.csv] [--model model.csv]
+//                      [--mode realtime|speedup|bursty|max] [--rate 9]
+//                      [--speedup 10] [--burst 8] [--deadline-us 1000]
+//                      [--limit <frames>] [--repeat 1] [--pin <cpu>]
+//                      [--cache <slots>]
+//
+// The UCI robot recorded at 9 frames per second, so --rate 9 --mode realtime
+// is what the controller sees. Latency is measured from the frame's scheduled
+// arrival, so time spent queued behind a slow frame counts against it; the
+// service time (inference alone) is reported separately. --pin keeps the replay
+// thread on one core to separate scheduler jitter from the cost of inference.
+// --cache puts a prediction cache of that many slots in front of predict().
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include "Layer.hpp"
+#include "NeuralNetwork.hpp"
+#include "CSVLoader.hpp"
+#include "LatencyHistogram.hpp"
+#include "Log.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct ReplayOptions {
+    string data_file = "sensor_readings_24.csv";
+    string model_file = "model.csv";
+    string mode = "realtime";   // realtime | speedup | bursty | max
+    double rate_hz = 9.0;       // recording rate of the dataset
+    double speedup = 10.0;
+    size_t burst = 8;
+    double deadline_us = 1000.0;
+    size_t limit = 0;           // 0 = every frame in the file
+    size_t repeat = 1;
+    int pin_cpu = -1;
+    size_t cache_slots = 0;     // 0 = no prediction cache
+};
+
+static bool pinCurrentThread(int cpu)
+{
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Sleep most of the way, then spin, so arrivals are accurate to a few microseconds
+static void waitUntil(Clock::time_point t)
+{
+    const auto spin_window = chrono::microseconds(200);
+    auto now = Clock::now();
+    if (t - now > spin_window)
+    {
+        this_thread::sleep_until(t - spin_window);
+    }
+    while (Clock::now() < t) {}
+}
+
+// Scheduled arrival of every frame, relative to the start of the replay
+static vector<Clock::duration> arrivalSchedule(const ReplayOptions& opt, size_t frames)
+{
+    vector<Clock::duration> schedule(frames, Clock::duration::zero());
+    if (opt.mode == "max")
+    {
+        return schedule;    // all frames are due at once: pure back-to-back throughput
+    }
+
+    double rate = opt.rate_hz;
+    if (opt.mode == "speedup")
+    {
+        rate *= opt.speedup;
+    }
+    else if (opt.mode != "realtime" && opt.mode != "bursty")
+    {
+        throw invalid_argument("Unknown replay mode: " + opt.mode);
+    }
+    if (rate <= 0.0)
+    {
+        throw invalid_argument("Replay rate must be positive !");
+    }
+
+    const double period_s = 1.0 / rate;
+    for (size_t k = 0; k < frames; ++k)
+    {
+        // bursty: same average rate, but frames arrive in groups of opt.burst
+        size_t slot = (opt.mode == "bursty") ? (k / opt.burst) * opt.burst : k;
+        schedule[k] = chrono::duration_cast<Clock::duration>(chrono::duration<double>(slot * period_s));
+    }
+    return schedule;
+}
+
+static ReplayOptions parseArgs(int argc, char** argv)
+{
+    ReplayOptions opt;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        auto value = [&]() -> string {
+            if (i + 1 >= argc)
+            {
+                throw invalid_argument("Missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--data") opt.data_file = value();
+        else if (arg == "--model") opt.model_file = value();
+        else if (arg == "--mode") opt.mode = value();
+        else if (arg == "--rate") opt.rate_hz = stod(value());
+        else if (arg == "--speedup") opt.speedup = stod(value());
+        else if (arg == "--burst") opt.burst = stoul(value());
+        else if (arg == "--deadline-us") opt.deadline_us = stod(value());
+        else if (arg == "--limit") opt.limit = stoul(value());
+        else if (arg == "--repeat") opt.repeat = stoul(value());
+        else if (arg == "--pin") opt.pin_cpu = stoi(value());
+        else if (arg == "--cache") opt.cache_slots = stoul(value());
+        else throw invalid_argument("Unknown option: " + arg);
+    }
+    if (opt.burst == 0 || opt.repeat == 0)
+    {
+        throw invalid_argument("--burst and --repeat must be positive !");
+    }
+    return opt;
+}
+
+int main(int argc, char** argv)
+{
+    try{
+        ReplayOptions opt = parseArgs(argc, argv);
+
+        vector<Layer> layers;
+        layers.emplace_back(0,24,ActivationType::None);
+        layers.emplace_back(1, 12, ActivationType::ReLU);
+        layers.emplace_back(2, 1, ActivationType::Sigmoid);
+
+        NeuralNetwork nn(layers);
+        if (!nn.loadModel(opt.model_file))
+        {
+            return 1;
+        }
+        if (opt.cache_slots > 0)
+        {
+            nn.enablePredictionCache(opt.cache_slots);
+        }
+
+        vector<vector<double>> frames;
+        vector<vector<double>> labels;
+        vector<int> ids;
+        if (!CSV::loadSensorData(opt.data_file, frames, labels, ids,
+                                 [](const string& l) { return CSV::isCollisionLabel(l) ? 1 : 0; }))
+        {
+            cerr << "Failed to load sensor data !\n";
+            return 1;
+        }
+
+        if (opt.limit > 0 && opt.limit < frames.size())
+        {
+            frames.resize(opt.limit);
+        }
+
+        vector<Clock::duration> schedule = arrivalSchedule(opt, frames.size());
+        const uint64_t deadline_ns = static_cast<uint64_t>(opt.deadline_us * 1e3);
+
+        LatencyHistogram latency;   // scheduled arrival -> prediction ready
+        LatencyHistogram service;   // inference alone
+        uint64_t misses = 0;
+        bool pinned = false;
+        double checksum = 0.0;
+
+        thread replay([&] {
+            if (opt.pin_cpu >= 0)
+            {
+                pinned = pinCurrentThread(opt.pin_cpu);
+            }
+
+            // Warm up caches and branch predictors before measuring
+            for (size_t k = 0; k < std::min<size_t>(frames.size(), 100); ++k)
+            {
+                checksum += nn.predict(frames[k])[0];
+            }
+            // The measured run must not hit entries the warm-up left behind
+            if (nn.getPredictionCache())
+            {
+                nn.getPredictionCache()->clear();
+                nn.getPredictionCache()->resetStats();
+            }
+
+            for (size_t r = 0; r < opt.repeat; ++r)
+            {
+                const auto start = Clock::now();
+                for (size_t k = 0; k < frames.size(); ++k)
+                {
+                    const auto arrival = start + schedule[k];
+                    waitUntil(arrival);
+
+                    const auto begin = Clock::now();
+                    checksum += nn.predict(frames[k])[0];
+                    const auto end = Clock::now();
+
+                    uint64_t total_ns = chrono::duration_cast<chrono::nanoseconds>(end - arrival).count();
+                    latency.record(total_ns);
+                    service.record(chrono::duration_cast<chrono::nanoseconds>(end - begin).count());
+                    if (total_ns > deadline_ns)
+                    {
+                        ++misses;
+                    }
+                }
+            }
+        });
+        replay.join();
+
+        stringstream data;
+        data << "-------------------Replay---------------------\n";
+        data << "Frames     : " << latency.count() << " (" << frames.size() << " x " << opt.repeat << ")"
+            << " from " << opt.data_file << "\n";
+        data << "Mode       : " << opt.mode;
+        if (opt.mode == "realtime" || opt.mode == "bursty") data << " @ " << opt.rate_hz << " Hz";
+        if (opt.mode == "speedup") data << " @ " << opt.rate_hz * opt.speedup << " Hz";
+        if (opt.mode == "bursty") data << ", bursts of " << opt.burst;
+        data << "\n";
+        data << "Pinned CPU : ";
+        if (opt.pin_cpu < 0) data << "no\n";
+        else data << opt.pin_cpu << (pinned ? "\n" : " (failed)\n");
+        data << "Latency    : " << latency.summary() << "\n";
+        data << "Service    : " << service.summary() << "\n";
+        data << fixed << setprecision(4);
+        data << "Deadline   : " << opt.deadline_us << " us, missed " << misses << " ("
+            << (latency.count() ? 100.0 * misses / latency.count() : 0.0) << "%)\n";
+        if (nn.getPredictionCache())
+        {
+            data << "Cache      : " << nn.getPredictionCache()->stats();
+        }
+        data << "Checksum   : " << checksum << "\n";
+        data << "----------------------------------------------\n";
+
+        cout << data.str();
+        L::log(data.str());
+
+    }catch(const exception &e){
+        cerr << " ERROR : " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}